@@ -0,0 +1,43 @@
+#ifndef EEPROM_LAYOUT_H
+#define EEPROM_LAYOUT_H
+
+#include <stdint.h>
+
+// Layout of the EEPROM, shared by the firmware and tools/provision which
+// builds EEPROM images
+
+#define EEPROM_LAYOUT_SIZE 1024 // Bytes, the ATmega328P EEPROM
+
+// Settings record, kept in a wear-leveled ring of CRC-checked slots in the
+// EEPROM below the user table (see ConfigStore)
+#define SETTINGS_ADDR 0
+#define SETTINGS_REGION_SIZE 256 // 12 slots of 20 bytes
+#define SETTINGS_VERSION 1
+
+// Layout before the settings record, migrated at the first boot
+#define LEGACY_MAGIC_MARKER "TOTP"  // 4-byte marker to verify EEPROM has been initialized
+#define LEGACY_MAGIC_ADDR 0         // Starting address for magic marker
+#define LEGACY_TZ_ADDR 4
+#define LEGACY_DRIFT_ADDR 5
+
+/**
+ * Settings kept across power cycles
+ * The size is fixed, new settings take reserved bytes (saved as 0 by
+ * older firmware) and bump SETTINGS_VERSION.
+ */
+struct Settings {
+  uint8_t version;
+  int8_t timezoneOffset; // Timezone offset in half-hours
+  int8_t drift;          // Learned clock drift, in 1/8 TOTP time steps
+  uint8_t reserved[13];
+};
+
+// EEPROM user table, user 0 is the compiled-in hmacKey and users 1 and up
+// are records of a length byte (1-20, anything else means no user)
+// followed by the secret, padded to EEPROM_USER_SIZE bytes
+#define EEPROM_USERS_ADDR 256
+#define EEPROM_USER_SIZE 24
+#define EEPROM_USER_KEY_LENGTH 20
+#define EEPROM_USER_COUNT ((EEPROM_LAYOUT_SIZE - EEPROM_USERS_ADDR) / EEPROM_USER_SIZE)
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HAL_ACTUATOR_H
+#define HAL_ACTUATOR_H
+
+#include <Arduino.h>
+
+/**
+ * The solenoid that holds the door locked
+ */
+class Actuator {
+public:
+  /**
+   * Set up the driver, the solenoid starts off (locked)
+   */
+  void begin();
+
+  /**
+   * Switch the solenoid
+   * @param energized true to pull the bolt (unlocked)
+   */
+  void set(bool energized);
+
+  bool isEnergized() const;
+};
+
+extern Actuator solenoid;
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include <Arduino.h>
+
+/**
+ * Wall clock time source
+ *
+ * On the board this is the DS3231 read through CachedRTC, on the host a
+ * virtual clock that advances with millis().
+ */
+class Clock {
+public:
+  /**
+   * Start the clock
+   * @return false if the clock hardware was not found
+   */
+  bool begin();
+
+  /**
+   * Housekeeping such as re-syncing, call this from loop()
+   */
+  void update();
+
+  /**
+   * Get the current time, cheap enough to call on every pass of loop()
+   * @return The unix time in seconds
+   */
+  uint32_t now();
+
+  /**
+   * Set the time
+   * @param unixTime The new unix time in seconds
+   */
+  void adjust(uint32_t unixTime);
+
+  /**
+   * Estimate the I2C transactions saved per hour by caching the time
+   */
+  uint32_t getI2CReadsSavedPerHour() const;
+};
+
+extern Clock rtcClock;
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef HAL_DISPLAY_H
+#define HAL_DISPLAY_H
+
+#include <Arduino.h>
+
+#define DISPLAY_WIDTH 240
+#define DISPLAY_HEIGHT 240
+
+// RGB565 colors, the same values as Adafruit_ST77xx.h
+#define ST77XX_BLACK 0x0000
+#define ST77XX_WHITE 0xFFFF
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_BLUE 0x001F
+#define ST77XX_CYAN 0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW 0xFFE0
+#define ST77XX_ORANGE 0xFC00
+
+// Uncomment to count the bytes sent to the display over SPI (see getSpiBytes())
+// #define TFT_SPI_STATS
+
+/**
+ * 240x240 color display
+ *
+ * The drawing calls the lock uses, with the semantics of Adafruit_GFX:
+ * text is drawn with the built-in 6x8 font scaled by the text size, and
+ * printing goes through Print so flash strings and numbers work as usual.
+ * On the board this is the ST7789 over SPI, on the host a fake that
+ * records what is on screen.
+ */
+class Display : public Print {
+public:
+  /**
+   * Initialize the display, rotated so the header pins are at the top
+   */
+  void begin();
+
+  int16_t width() const { return DISPLAY_WIDTH; }
+  int16_t height() const { return DISPLAY_HEIGHT; }
+
+  void fillScreen(uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  /**
+   * Batch drawing calls in one SPI transaction
+   * Only the write* calls may be used between startWrite() and endWrite().
+   */
+  void startWrite();
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void endWrite();
+
+  void setCursor(int16_t x, int16_t y);
+  void setTextSize(uint8_t size);
+  void setTextColor(uint16_t color);
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  /**
+   * Draw text in the large digit font (lib/DigitFont)
+   * Each character cell is DIGIT_FONT_WIDTH * size by DIGIT_FONT_HEIGHT * size
+   * pixels and goes through a single address window, background included, so
+   * nothing has to be cleared first. Cells that would not fit on the screen
+   * are left out. Does not move the text cursor.
+   * @param x The left of the first cell
+   * @param y The top of the cells
+   * @param text The characters, those the font lacks are drawn blank
+   * @param size The scale, 1 to 10
+   * @param color The color of the characters
+   * @param background The color of the rest of the cells
+   */
+  void drawDigits(int16_t x, int16_t y, const char* text, uint8_t size, uint16_t color, uint16_t background);
+
+#ifdef TFT_SPI_STATS
+  /**
+   * Get the bytes sent to the display since the last resetSpiBytes()
+   */
+  unsigned long getSpiBytes() const;
+  void resetSpiBytes();
+#endif
+};
+
+extern Display display;
+
+#ifdef DISPLAY_PROFILING
+/**
+ * Attributes the display traffic while it exists to a name
+ * Scopes nest, traffic counts towards every scope that is open.
+ */
+class DisplayScope {
+public:
+  explicit DisplayScope(const char* name);
+  ~DisplayScope();
+};
+
+// Count the display traffic of the enclosing function under its name
+#define DISPLAY_SCOPE() DisplayScope displayScope(__func__)
+#else
+#define DISPLAY_SCOPE()
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef HAL_FRAM_H
+#define HAL_FRAM_H
+
+#include <Arduino.h>
+
+#define FRAM_SIZE 32768U // Bytes, an MB85RC256V
+
+/**
+ * External I2C FRAM for the audit log
+ *
+ * On the board this is an MB85RC256V on the RTC's I2C bus, on the host
+ * it is kept in memory. FRAM writes take bus time only, with no write
+ * cycle delay and no wear to speak of.
+ */
+class Fram {
+public:
+  /**
+   * Check that the FRAM answers
+   * @return false if it was not found
+   */
+  bool begin();
+
+  /**
+   * Read bytes
+   * @return false if the FRAM did not answer
+   */
+  bool read(uint16_t address, uint8_t* data, uint8_t length);
+
+  /**
+   * Write bytes
+   * @return false if the FRAM did not answer
+   */
+  bool write(uint16_t address, const uint8_t* data, uint8_t length);
+
+  uint16_t length() const { return FRAM_SIZE; }
+};
+
+extern Fram fram;
+
+#endif
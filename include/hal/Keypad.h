@@ -0,0 +1,43 @@
+#ifndef HAL_KEYPAD_H
+#define HAL_KEYPAD_H
+
+#include <Arduino.h>
+
+/**
+ * A debounced key press
+ */
+struct KeyEvent {
+  char key;            // The key pressed
+  unsigned long time;  // millis() when the key went down
+};
+
+/**
+ * 16-key keypad (0-9, A-D, * and #)
+ *
+ * Key presses are queued in the background and read without blocking. On
+ * the board this is the resistor-ladder keypad sampled by KeypadSampler,
+ * on the host a queue filled by the simulation.
+ */
+class Keypad {
+public:
+  /**
+   * Start collecting key presses
+   */
+  void begin();
+
+  /**
+   * Get the next key press without blocking
+   * @param event Receives the key press
+   * @return false if no key was pressed
+   */
+  bool readEvent(KeyEvent& event);
+
+  /**
+   * Get the number of key presses dropped because the queue was full
+   */
+  uint8_t getDroppedEvents() const;
+};
+
+extern Keypad keypad;
+
+#endif
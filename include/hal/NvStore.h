@@ -0,0 +1,23 @@
+#ifndef HAL_NV_STORE_H
+#define HAL_NV_STORE_H
+
+#include <Arduino.h>
+
+#define NV_STORE_SIZE 1024 // Bytes, the size of the ATmega328P EEPROM
+
+/**
+ * Byte-addressed nonvolatile storage
+ *
+ * On the board this is the internal EEPROM, erased cells read 0xFF.
+ * On the host it is kept in memory.
+ */
+class NvStore {
+public:
+  uint8_t read(uint16_t address);
+  void write(uint16_t address, uint8_t value);
+  uint16_t length() const { return NV_STORE_SIZE; }
+};
+
+extern NvStore nvStore;
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef HAL_STACK_MONITOR_H
+#define HAL_STACK_MONITOR_H
+
+#include <Arduino.h>
+
+// Not in the bench env, painting would show up in the cycle counts
+#if defined(__AVR__) && !defined(BENCHMARK)
+#define STACK_MONITOR
+#endif
+
+#define STACK_PAINT 0xC5          // Value free SRAM is painted with
+#define STACK_MAX_FUNCTIONS 12    // Functions with a STACK_SCOPE() that are tracked
+#define STACK_MAX_DEPTH 6         // Nested STACK_SCOPE()s that are tracked
+
+/**
+ * Free SRAM and stack depth telemetry
+ *
+ * At boot, before the C runtime starts, all SRAM above the static data is
+ * painted with STACK_PAINT. Whatever the stack (or an interrupt) has used
+ * since no longer holds the paint, so scanning up from the heap for the
+ * first changed byte gives the lowest the stack has ever been.
+ *
+ * STACK_SCOPE() measures one function: on entry it scans, then repaints
+ * the free SRAM below the current stack pointer, on exit it scans again,
+ * which gives the deepest the stack went during the call including
+ * callees and interrupts. This costs a pass over the free SRAM, so it
+ * goes on the major functions only, not on anything called every pass
+ * of loop().
+ *
+ * On the host there is nothing to measure and everything reports 0.
+ */
+class StackMonitor {
+public:
+  /**
+   * Get the free SRAM between the heap and the stack right now
+   */
+  static uint16_t getFreeRam();
+
+  /**
+   * Get the smallest free SRAM seen since boot
+   */
+  static uint16_t getMinFreeRam();
+
+  /**
+   * Print the free SRAM and the peak stack use of every STACK_SCOPE()
+   */
+  static void printReport(Print& out);
+
+#ifdef STACK_MONITOR
+  /**
+   * Measures the stack use from its construction to its destruction
+   */
+  class Scope {
+  public:
+    explicit Scope(PGM_P name);
+    ~Scope();
+  };
+#endif
+};
+
+#ifdef STACK_MONITOR
+// Record the peak stack use of the enclosing block under a name
+#define STACK_SCOPE(name) StackMonitor::Scope stackScope(PSTR(name))
+#else
+#define STACK_SCOPE(name)
+#endif
+
+#endif
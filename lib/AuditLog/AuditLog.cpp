@@ -0,0 +1,116 @@
+#include "AuditLog.h"
+#include <Crc16.h>
+
+void AuditRecord::encode(uint8_t* bytes) const {
+  bytes[0] = time;
+  bytes[1] = time >> 8;
+  bytes[2] = time >> 16;
+  bytes[3] = time >> 24;
+  bytes[4] = event;
+  bytes[5] = user;
+  bytes[6] = (uint8_t)offset;
+  bytes[7] = flags;
+}
+
+void AuditRecord::decode(const uint8_t* bytes) {
+  time = bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+  event = bytes[4];
+  user = bytes[5];
+  offset = (int8_t)bytes[6];
+  flags = bytes[7];
+}
+
+bool AuditLog::begin() {
+  uint8_t header[AUDIT_HEADER_SIZE];
+  if (capacity == 0 || !readBytes(address, header, sizeof(header))) {
+    return false;
+  }
+  ready = true;
+
+  uint16_t magic = header[0] | (uint16_t)header[1] << 8;
+  uint16_t storedHead = header[2] | (uint16_t)header[3] << 8;
+  uint16_t storedCount = header[4] | (uint16_t)header[5] << 8;
+  uint16_t storedCrc = header[6] | (uint16_t)header[7] << 8;
+  if (magic == AUDIT_MAGIC && crc16(header, 6) == storedCrc && storedHead < capacity && storedCount <= capacity) {
+    head = storedHead;
+    count = storedCount;
+    return true;
+  }
+
+  head = 0;
+  count = 0;
+  return writeHeader();
+}
+
+bool AuditLog::writeHeader() {
+  uint8_t header[AUDIT_HEADER_SIZE] = {
+    (uint8_t)AUDIT_MAGIC, (uint8_t)(AUDIT_MAGIC >> 8),
+    (uint8_t)head, (uint8_t)(head >> 8),
+    (uint8_t)count, (uint8_t)(count >> 8)
+  };
+  uint16_t crc = crc16(header, 6);
+  header[6] = crc;
+  header[7] = crc >> 8;
+  return writeBytes(address, header, sizeof(header));
+}
+
+bool AuditLog::append(const AuditRecord& record) {
+  if (!ready) {
+    return false;
+  }
+  if (!queue.push(record)) {
+    dropped++;
+    return false;
+  }
+  return true;
+}
+
+bool AuditLog::flush() {
+  AuditRecord record;
+  if (!queue.pop(record)) {
+    return false;
+  }
+
+  // When the log is full the slot holds the oldest record, drop it from
+  // the log before overwriting it
+  if (count == capacity) {
+    count--;
+    if (!writeHeader()) {
+      count++;
+      dropped++;
+      return false;
+    }
+  }
+
+  uint8_t bytes[AUDIT_RECORD_SIZE];
+  record.encode(bytes);
+  if (!writeBytes(slotAddress(head), bytes, sizeof(bytes))) {
+    dropped++;
+    return false;
+  }
+
+  // The record only becomes part of the log once the header points past it
+  head = (head + 1) % capacity;
+  count++;
+  if (!writeHeader()) {
+    // The store still has the previous header, keep to what it holds
+    head = (head + capacity - 1) % capacity;
+    count--;
+    dropped++;
+    return false;
+  }
+  return true;
+}
+
+bool AuditLog::read(uint16_t index, AuditRecord& record) {
+  if (index >= count) {
+    return false;
+  }
+  uint16_t slot = (head + capacity - count + index) % capacity;
+  uint8_t bytes[AUDIT_RECORD_SIZE];
+  if (!readBytes(slotAddress(slot), bytes, sizeof(bytes))) {
+    return false;
+  }
+  record.decode(bytes);
+  return true;
+}
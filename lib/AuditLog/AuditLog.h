@@ -0,0 +1,125 @@
+#ifndef AUDIT_LOG_H
+#define AUDIT_LOG_H
+
+#include <stdint.h>
+#include <SPSCQueue.h>
+
+#define AUDIT_RECORD_SIZE 8  // Bytes per record in the store and in a dump
+#define AUDIT_HEADER_SIZE 8  // Magic, head, count and CRC at the start of the region
+#define AUDIT_QUEUE_SIZE 4   // Records waiting to be written, a power of two
+#define AUDIT_MAGIC 0x4C41   // "AL"
+
+/**
+ * What happened
+ */
+enum AuditEvent : uint8_t {
+  AUDIT_DENIED = 0,  // A code was entered and did not match
+  AUDIT_GRANTED = 1  // A code matched and the lock opened
+};
+
+/**
+ * One access attempt
+ */
+struct AuditRecord {
+  uint32_t time;   // Unix time of the attempt, from the RTC
+  uint8_t event;   // AuditEvent
+  uint8_t user;    // The user whose code matched, 0xFF if none did
+  int8_t offset;   // Matched time step offset, INT8_MIN if none did
+  uint8_t flags;   // Reserved, 0
+
+  /**
+   * Pack the record, little endian
+   * @param bytes Buffer for AUDIT_RECORD_SIZE bytes
+   */
+  void encode(uint8_t* bytes) const;
+
+  /**
+   * Unpack a record packed by encode()
+   */
+  void decode(const uint8_t* bytes);
+};
+
+/**
+ * Reads bytes of the store
+ * @return false if the store did not answer
+ */
+typedef bool (*AuditRead)(uint16_t address, uint8_t* data, uint8_t length);
+
+/**
+ * Writes bytes of the store
+ * @return false if the store did not answer
+ */
+typedef bool (*AuditWrite)(uint16_t address, const uint8_t* data, uint8_t length);
+
+/**
+ * Append-only circular log of access attempts
+ *
+ * The region starts with a header (AUDIT_MAGIC, the slot the next record
+ * goes to, the number of records and a CRC-16) followed by fixed-size
+ * records. When the region is full the oldest record is overwritten, after
+ * a header that leaves it out of the log. It is meant for FRAM, which has
+ * no write wear to speak of, so the header is rewritten after every record.
+ * A record that was written without its header update is simply not part
+ * of the log, and neither is the slot it went to.
+ *
+ * append() only queues the record in RAM, the store is written by flush(),
+ * one record per call from loop(), so logging never holds up the unlock.
+ */
+class AuditLog {
+public:
+  /**
+   * @param address The first byte of the region
+   * @param size The size of the region in bytes
+   * @param read Reads the store
+   * @param write Writes the store
+   */
+  AuditLog(uint16_t address, uint16_t size, AuditRead read, AuditWrite write)
+    : address(address), capacity((size - AUDIT_HEADER_SIZE) / AUDIT_RECORD_SIZE), readBytes(read), writeBytes(write) {}
+
+  /**
+   * Read the header, a region without a valid one is started empty
+   * @return false if the store did not answer, the log stays disabled
+   */
+  bool begin();
+
+  /**
+   * Queue a record, does not touch the store
+   * @return false if the log is disabled or the queue was full and the record was dropped
+   */
+  bool append(const AuditRecord& record);
+
+  /**
+   * Write one queued record and the header
+   * @return true if a record was written
+   */
+  bool flush();
+
+  /**
+   * Read a record
+   * @param index 0 for the oldest record up to getCount() - 1 for the newest
+   * @param record Receives the record
+   * @return false if there is no such record or the store did not answer
+   */
+  bool read(uint16_t index, AuditRecord& record);
+
+  bool isReady() const { return ready; }
+  uint16_t getCount() const { return count; }
+  uint16_t getCapacity() const { return capacity; }
+  uint16_t getDropped() const { return dropped; }
+
+private:
+  uint16_t address;
+  uint16_t capacity; // Records that fit in the region
+  AuditRead readBytes;
+  AuditWrite writeBytes;
+  bool ready = false;
+  uint16_t head = 0;  // Slot the next record goes to
+  uint16_t count = 0; // Records in the log
+  uint16_t dropped = 0;
+  SPSCQueue<AuditRecord, AUDIT_QUEUE_SIZE> queue;
+
+  uint16_t slotAddress(uint16_t slot) const { return address + AUDIT_HEADER_SIZE + slot * AUDIT_RECORD_SIZE; }
+  bool writeHeader();
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "Base32.h"
+
+const Base32Tables base32Tables PROGMEM = makeBase32Tables();
+
+int Base32::encode(const uint8_t* data, int dataLength, char* result, int bufSize) {
+  int length = base32EncodedLength(dataLength);
+  if (length >= bufSize) {
+    return -1;
+  }
+
+  char* out = result;
+  for (int i = 0; i < dataLength; i += 5) {
+    // A group of 5 bytes, zero padded at the end of the data
+    uint8_t b[5] = {0, 0, 0, 0, 0};
+    for (uint8_t j = 0; j < 5 && i + j < dataLength; j++) {
+      b[j] = data[i + j];
+    }
+    uint8_t values[8] = {
+      (uint8_t)(b[0] >> 3),
+      (uint8_t)((b[0] & 0x07) << 2 | b[1] >> 6),
+      (uint8_t)((b[1] >> 1) & 0x1F),
+      (uint8_t)((b[1] & 0x01) << 4 | b[2] >> 4),
+      (uint8_t)((b[2] & 0x0F) << 1 | b[3] >> 7),
+      (uint8_t)((b[3] >> 2) & 0x1F),
+      (uint8_t)((b[3] & 0x03) << 3 | b[4] >> 5),
+      (uint8_t)(b[4] & 0x1F)
+    };
+    for (uint8_t j = 0; j < 8 && out < result + length; j++) {
+      *out++ = pgm_read_byte(&base32Tables.alphabet[values[j]]);
+    }
+  }
+  *out = '\0';
+  return length;
+}
+
+int Base32::decode(const char* text, uint8_t* result, int bufSize) {
+  uint16_t buffer = 0; // Holds at most 12 pending bits
+  uint8_t bits = 0;
+  int length = 0;
+
+  for (; *text != '\0' && *text != '='; text++) {
+    char c = *text;
+    if (c == ' ' || c == '-') {
+      continue;
+    }
+    if (c < BASE32_FIRST_CHAR || c > BASE32_LAST_CHAR) {
+      return -1;
+    }
+    uint8_t value = pgm_read_byte(&base32Tables.values[c - BASE32_FIRST_CHAR]);
+    if (value == BASE32_INVALID) {
+      return -1;
+    }
+
+    buffer = buffer << 5 | value;
+    bits += 5;
+    if (bits >= 8) {
+      if (length == bufSize) {
+        return -1;
+      }
+      bits -= 8;
+      result[length++] = buffer >> bits;
+      buffer &= (1 << bits) - 1;
+    }
+  }
+  return length;
+}
+
+// RFC 4648 section 10 test vectors, checked by the compiler against
+// base32Encode() and by the bench env against Base32 at runtime
+
+constexpr bool base32EncodesTo(const char* text, const char* expected) {
+  uint8_t data[8]{};
+  int length = 0;
+  for (; text[length] != '\0'; length++) {
+    data[length] = text[length];
+  }
+  char result[20]{};
+  base32Encode(data, length, result, sizeof(result));
+  for (int i = 0; expected[i] != '\0' || result[i] != '\0'; i++) {
+    if (result[i] != expected[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(base32EncodesTo("", ""), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("f", "MY"), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("fo", "MZXQ"), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("foo", "MZXW6"), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("foob", "MZXW6YQ"), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("fooba", "MZXW6YTB"), "RFC 4648 base32 vector");
+static_assert(base32EncodesTo("foobar", "MZXW6YTBOI"), "RFC 4648 base32 vector");
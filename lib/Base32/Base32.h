@@ -0,0 +1,125 @@
+#ifndef BASE32_H
+#define BASE32_H
+
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#endif
+#endif
+
+#define BASE32_FIRST_CHAR '0'  // Lowest character the decode table covers
+#define BASE32_LAST_CHAR 'z'   // Highest character the decode table covers
+#define BASE32_INVALID 0xFF    // Decode table entry of a character outside the alphabet
+
+/**
+ * Encoded length of some bytes, without padding or null terminator
+ */
+constexpr int base32EncodedLength(int dataLength) {
+  return (dataLength * 8 + 4) / 5;
+}
+
+/**
+ * Lookup tables of the base32 codec, built by the compiler
+ */
+struct Base32Tables {
+  char alphabet[32];                                    // Value to character
+  uint8_t values[BASE32_LAST_CHAR - BASE32_FIRST_CHAR + 1]; // Character to value, upper and lower case
+};
+
+/**
+ * Build the base32 lookup tables from the RFC 4648 alphabet
+ */
+constexpr Base32Tables makeBase32Tables() {
+  Base32Tables tables{};
+  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+  for (int i = 0; i <= BASE32_LAST_CHAR - BASE32_FIRST_CHAR; i++) {
+    tables.values[i] = BASE32_INVALID;
+  }
+  for (uint8_t value = 0; value < 32; value++) {
+    char c = chars[value];
+    tables.alphabet[value] = c;
+    tables.values[c - BASE32_FIRST_CHAR] = value;
+    if (c >= 'A' && c <= 'Z') {
+      tables.values[c - 'A' + 'a' - BASE32_FIRST_CHAR] = value;
+    }
+  }
+  return tables;
+}
+
+extern const Base32Tables base32Tables PROGMEM;
+
+/**
+ * Table-driven base32 codec for runtime use (RFC 4648 alphabet)
+ * The tables are in flash. Use base32Encode() where the result must be
+ * known at compile time.
+ */
+class Base32 {
+public:
+  /**
+   * Encode bytes, without padding
+   * Every 5 bytes become 8 characters looked up in the alphabet table.
+   * @param data The data to encode
+   * @param dataLength The length of the data
+   * @param result Buffer for base32EncodedLength(dataLength) + 1 characters
+   * @param bufSize The size of the result buffer
+   * @return The number of characters, -1 if the buffer is too small
+   */
+  static int encode(const uint8_t* data, int dataLength, char* result, int bufSize);
+
+  /**
+   * Decode base32 text
+   * Upper and lower case are accepted, spaces and dashes are skipped and
+   * '=' padding ends the text.
+   * @param text The null terminated text
+   * @param result Buffer for the decoded bytes
+   * @param bufSize The size of the result buffer
+   * @return The number of bytes, -1 if the text is not base32 or does not fit
+   */
+  static int decode(const char* text, uint8_t* result, int bufSize);
+};
+
+/**
+ * Base32 encoding function for TOTP secrets (RFC 4648 alphabet, no padding)
+ * The function is constexpr so the otpauth URI of a compile-time secret
+ * can be built by the compiler. At runtime Base32::encode() is faster.
+ * @param data The data to encode
+ * @param dataLength The length of the data
+ * @param result The buffer to store the encoded result
+ * @param bufSize The size of the result buffer
+ */
+constexpr void base32Encode(const uint8_t* data, int dataLength, char* result, int bufSize) {
+  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+  int resultIndex = 0;
+  int bits = 0;
+  unsigned int value = 0; // Holds at most 12 pending bits, so it never overflows
+
+  for (int i = 0; i < dataLength; i++) {
+    value = (value << 8) | data[i];
+    bits += 8;
+
+    while (bits >= 5) {
+      if (resultIndex < bufSize - 1) {
+        result[resultIndex++] = chars[(value >> (bits - 5)) & 0x1F];
+      }
+      bits -= 5;
+    }
+    value &= (1u << bits) - 1;
+  }
+
+  // If we have remaining bits
+  if (bits > 0 && resultIndex < bufSize - 1) {
+    result[resultIndex++] = chars[(value << (5 - bits)) & 0x1F];
+  }
+
+  // Null terminate
+  result[resultIndex] = 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "ConfigStore.h"
+#include <string.h>
+#include <Crc16.h>
+
+/**
+ * Read a slot and check its CRC
+ * @param slot The slot
+ * @param slotSequence Set to the sequence number of the slot
+ * @param record Buffer for recordSize bytes, filled even if the CRC is bad
+ * @return true if the CRC matches
+ */
+bool ConfigStore::readSlot(uint8_t slot, uint16_t& slotSequence, void* record) {
+  uint16_t at = slotAddress(slot);
+  uint16_t crc = CRC16_INITIAL;
+
+  uint8_t low = readByte(at++);
+  uint8_t high = readByte(at++);
+  crc = crc16Update(crc16Update(crc, low), high);
+  slotSequence = low | (uint16_t)high << 8;
+
+  uint8_t* bytes = (uint8_t*)record;
+  for (uint8_t i = 0; i < recordSize; i++) {
+    bytes[i] = readByte(at++);
+    crc = crc16Update(crc, bytes[i]);
+  }
+
+  uint16_t storedCrc = readByte(at) | (uint16_t)readByte(at + 1) << 8;
+  return crc == storedCrc;
+}
+
+bool ConfigStore::load(void* record) {
+  uint8_t slotRecord[CONFIG_MAX_RECORD_SIZE];
+  currentSlot = CONFIG_NO_SLOT;
+
+  for (uint8_t slot = 0; slot < slotCount; slot++) {
+    uint16_t slotSequence;
+    if (!readSlot(slot, slotSequence, slotRecord)) {
+      continue;
+    }
+    // Sequence numbers wrap, newer means less than half the range ahead
+    if (currentSlot == CONFIG_NO_SLOT || (int16_t)(slotSequence - sequence) > 0) {
+      currentSlot = slot;
+      sequence = slotSequence;
+      memcpy(record, slotRecord, recordSize);
+    }
+  }
+  return currentSlot != CONFIG_NO_SLOT;
+}
+
+/**
+ * Write a byte unless the store already holds it
+ * @return 1 if the byte was written, 0 otherwise
+ */
+uint16_t ConfigStore::update(uint16_t at, uint8_t value) {
+  if (readByte(at) == value) {
+    return 0;
+  }
+  writeByte(at, value);
+  return 1;
+}
+
+uint16_t ConfigStore::save(const void* record) {
+  if (currentSlot != CONFIG_NO_SLOT) {
+    uint8_t currentRecord[CONFIG_MAX_RECORD_SIZE];
+    uint16_t currentSequence;
+    if (readSlot(currentSlot, currentSequence, currentRecord) && memcmp(currentRecord, record, recordSize) == 0) {
+      return 0;
+    }
+  }
+
+  uint8_t slot = currentSlot == CONFIG_NO_SLOT ? 0 : (currentSlot + 1) % slotCount;
+  uint16_t nextSequence = sequence + 1;
+  uint16_t at = slotAddress(slot);
+  uint16_t written = 0;
+
+  uint16_t crc = crc16Update(crc16Update(CRC16_INITIAL, nextSequence), nextSequence >> 8);
+  written += update(at++, nextSequence);
+  written += update(at++, nextSequence >> 8);
+
+  const uint8_t* bytes = (const uint8_t*)record;
+  for (uint8_t i = 0; i < recordSize; i++) {
+    crc = crc16Update(crc, bytes[i]);
+    written += update(at++, bytes[i]);
+  }
+
+  written += update(at++, crc);
+  written += update(at, crc >> 8);
+
+  currentSlot = slot;
+  sequence = nextSequence;
+  return written;
+}
@@ -0,0 +1,90 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+
+#define CONFIG_MAX_RECORD_SIZE 32 // Largest record, load() and save() keep one on the stack
+#define CONFIG_NO_SLOT 0xFF
+#define CONFIG_SLOT_OVERHEAD 4 // Sequence number and CRC around each record
+
+/**
+ * Reads a byte of the nonvolatile store
+ */
+typedef uint8_t (*ConfigReadByte)(uint16_t address);
+
+/**
+ * Writes a byte of the nonvolatile store
+ */
+typedef void (*ConfigWriteByte)(uint16_t address, uint8_t value);
+
+/**
+ * Wear-leveled store for one fixed-size configuration record
+ *
+ * The region is divided into slots of a 16-bit sequence number, the
+ * record and a CRC-16 of both. Every save goes to the slot after the
+ * current one with the next sequence number, so the writes rotate over
+ * the whole region instead of wearing out the same cells. Only bytes
+ * that differ from what the slot holds are written, and a record equal
+ * to the current one is not written at all.
+ *
+ * load() scans the slots once and takes the valid one with the newest
+ * sequence number. A save interrupted by a power loss leaves a slot with
+ * a bad CRC, so the previous record is found instead.
+ *
+ * The record layout belongs to the caller and its size is fixed for the
+ * life of the region. Keep a version and reserved bytes in it, so later
+ * firmware can give the reserved bytes a meaning and convert the records
+ * older firmware saved.
+ */
+class ConfigStore {
+public:
+  /**
+   * @param address The first byte of the region
+   * @param size The size of the region in bytes
+   * @param recordSize The size of the record in bytes, at most CONFIG_MAX_RECORD_SIZE
+   * @param readByte Reads the nonvolatile store
+   * @param writeByte Writes the nonvolatile store
+   */
+  ConfigStore(uint16_t address, uint16_t size, uint8_t recordSize, ConfigReadByte readByte, ConfigWriteByte writeByte)
+    : address(address), slotCount(size / (recordSize + CONFIG_SLOT_OVERHEAD)), recordSize(recordSize),
+      readByte(readByte), writeByte(writeByte) {}
+
+  /**
+   * Find the newest valid record
+   * @param record Buffer for recordSize bytes, left unchanged if there is none
+   * @return true if a valid record was found
+   */
+  bool load(void* record);
+
+  /**
+   * Save a record in the next slot
+   * @param record The record, recordSize bytes
+   * @return The number of bytes written, 0 if the record was unchanged
+   */
+  uint16_t save(const void* record);
+
+  /**
+   * Get the number of slots the writes rotate over
+   */
+  uint8_t getSlotCount() const { return slotCount; }
+
+  /**
+   * Get the slot holding the current record, CONFIG_NO_SLOT if none
+   */
+  uint8_t getCurrentSlot() const { return currentSlot; }
+
+private:
+  uint16_t address;
+  uint8_t slotCount;
+  uint8_t recordSize;
+  ConfigReadByte readByte;
+  ConfigWriteByte writeByte;
+  uint8_t currentSlot = CONFIG_NO_SLOT;
+  uint16_t sequence = 0; // Sequence number of the current record
+
+  uint16_t slotAddress(uint8_t slot) const { return address + slot * (recordSize + CONFIG_SLOT_OVERHEAD); }
+  bool readSlot(uint8_t slot, uint16_t& slotSequence, void* record);
+  uint16_t update(uint16_t at, uint8_t value);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+#define CRC16_INITIAL 0xFFFF
+
+/**
+ * Add a byte to a CRC-16/CCITT-FALSE (polynomial 0x1021, initial value
+ * CRC16_INITIAL, no reflection, no final XOR)
+ * Computed bit by bit, a lookup table would cost 512 bytes of flash.
+ * @param crc The CRC of the bytes so far
+ * @param value The next byte
+ * @return The CRC including the byte
+ */
+inline uint16_t crc16Update(uint16_t crc, uint8_t value) {
+  crc ^= (uint16_t)value << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+/**
+ * Compute the CRC-16/CCITT-FALSE of a buffer
+ * @param data The bytes
+ * @param length The number of bytes
+ * @return The CRC
+ */
+inline uint16_t crc16(const uint8_t* data, uint16_t length) {
+  uint16_t crc = CRC16_INITIAL;
+  for (uint16_t i = 0; i < length; i++) {
+    crc = crc16Update(crc, data[i]);
+  }
+  return crc;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include "DigitFont.h"
+
+// Characters of the glyphs after the digits, in glyph order
+static const char digitFontSymbols[] PROGMEM = ":_APM ";
+
+const uint8_t digitFontGlyphs[DIGIT_FONT_GLYPHS][DIGIT_FONT_COLUMNS] PROGMEM = {
+  {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+  {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+  {0x72, 0x49, 0x49, 0x49, 0x46}, // 2
+  {0x21, 0x41, 0x49, 0x4D, 0x33}, // 3
+  {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+  {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+  {0x3C, 0x4A, 0x49, 0x49, 0x31}, // 6
+  {0x41, 0x21, 0x11, 0x09, 0x07}, // 7
+  {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+  {0x46, 0x49, 0x49, 0x29, 0x1E}, // 9
+  {0x00, 0x00, 0x14, 0x00, 0x00}, // :
+  {0x40, 0x40, 0x40, 0x40, 0x40}, // _
+  {0x7C, 0x12, 0x11, 0x12, 0x7C}, // A
+  {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+  {0x7F, 0x02, 0x1C, 0x02, 0x7F}, // M
+  {0x00, 0x00, 0x00, 0x00, 0x00}  // space
+};
+
+uint8_t digitFontGlyph(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  for (uint8_t i = 0; i < sizeof(digitFontSymbols) - 1; i++) {
+    if ((char)pgm_read_byte(&digitFontSymbols[i]) == c) {
+      return 10 + i;
+    }
+  }
+  return DIGIT_FONT_BLANK;
+}
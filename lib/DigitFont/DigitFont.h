@@ -0,0 +1,76 @@
+#ifndef DIGIT_FONT_H
+#define DIGIT_FONT_H
+
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#endif
+#endif
+
+#define DIGIT_FONT_COLUMNS 5    // Inked columns of a glyph
+#define DIGIT_FONT_WIDTH 6      // Columns of a character cell, the last one is spacing
+#define DIGIT_FONT_HEIGHT 7     // Rows of a character cell, none of the glyphs has a descender
+#define DIGIT_FONT_GLYPHS 16
+#define DIGIT_FONT_BLANK 15     // Glyph of a space, also drawn for characters the font lacks
+
+// The characters the lock draws large: the code entry digits and
+// placeholder, and the clock. The glyphs are those of the Adafruit_GFX
+// built-in font, so the screen looks the same as when they were printed.
+
+/**
+ * Glyphs in flash, DIGIT_FONT_COLUMNS columns each, bit 0 of a column is the top row
+ */
+extern const uint8_t digitFontGlyphs[DIGIT_FONT_GLYPHS][DIGIT_FONT_COLUMNS] PROGMEM;
+
+/**
+ * Find the glyph of a character
+ * @return The glyph index, DIGIT_FONT_BLANK if the font lacks the character
+ */
+uint8_t digitFontGlyph(char c);
+
+/**
+ * Stream a character cell scaled by size as runs of pixels of one color
+ *
+ * The cell is DIGIT_FONT_WIDTH * size by DIGIT_FONT_HEIGHT * size pixels,
+ * sent row by row from the top left like an ST7789 address window is filled.
+ * Background is sent too, so the cell covers whatever was under it. A run
+ * continues over row ends, so a blank row costs no extra run.
+ * @param out Anything with a writeColor(uint16_t color, uint16_t count)
+ * @param glyph The glyph index from digitFontGlyph()
+ * @param size The scale, 1 to 10
+ * @param color The color of the inked pixels
+ * @param background The color of the other pixels
+ */
+template <typename Output>
+void digitFontDraw(Output& out, uint8_t glyph, uint8_t size, uint16_t color, uint16_t background) {
+  uint8_t columns[DIGIT_FONT_COLUMNS];
+  for (uint8_t i = 0; i < DIGIT_FONT_COLUMNS; i++) {
+    columns[i] = pgm_read_byte(&digitFontGlyphs[glyph][i]);
+  }
+
+  bool inked = false; // Color of the pending run
+  uint16_t count = 0; // Pixels in the pending run
+  for (uint8_t row = 0; row < DIGIT_FONT_HEIGHT; row++) {
+    for (uint8_t repeat = 0; repeat < size; repeat++) {
+      for (uint8_t column = 0; column < DIGIT_FONT_WIDTH; column++) {
+        bool pixel = column < DIGIT_FONT_COLUMNS && (columns[column] >> row & 1);
+        if (pixel != inked && count > 0) {
+          out.writeColor(inked ? color : background, count);
+          count = 0;
+        }
+        inked = pixel;
+        count += size;
+      }
+    }
+  }
+  out.writeColor(inked ? color : background, count);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+#include <Crc16.h>
+
+#define FRAME_SYNC 0xA5         // First byte of every frame, never sent in text
+#define FRAME_OVERHEAD 5        // Sync, type, length and CRC around the payload
+#define FRAME_MAX_PAYLOAD 255
+
+/**
+ * Write a binary frame: FRAME_SYNC, type, payload length, payload and the
+ * CRC-16/CCITT-FALSE of type, length and payload, low byte first
+ *
+ * The serial log is ASCII, so a reader finds frames in it by looking for
+ * FRAME_SYNC and checking the CRC. Multi-byte payload fields are little
+ * endian.
+ * @param out Anything with a write(uint8_t), such as Serial
+ * @param type The frame type
+ * @param payload The payload
+ * @param length The length of the payload
+ */
+template <typename Output>
+void writeFrame(Output& out, uint8_t type, const uint8_t* payload, uint8_t length) {
+  uint16_t crc = crc16Update(crc16Update(CRC16_INITIAL, type), length);
+  out.write((uint8_t)FRAME_SYNC);
+  out.write(type);
+  out.write(length);
+  for (uint8_t i = 0; i < length; i++) {
+    out.write(payload[i]);
+    crc = crc16Update(crc, payload[i]);
+  }
+  out.write((uint8_t)crc);
+  out.write((uint8_t)(crc >> 8));
+}
+
+#endif
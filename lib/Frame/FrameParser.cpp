@@ -0,0 +1,51 @@
+#include "FrameParser.h"
+
+bool FrameParser::feed(uint8_t value) {
+  switch (state) {
+    case WAIT_SYNC:
+      if (value == FRAME_SYNC) {
+        state = READ_TYPE;
+      }
+      return false;
+
+    case READ_TYPE:
+      type = value;
+      crc = crc16Update(CRC16_INITIAL, value);
+      state = READ_LENGTH;
+      return false;
+
+    case READ_LENGTH:
+      if (value > FRAME_PARSER_SIZE) {
+        errors++;
+        state = WAIT_SYNC;
+        return false;
+      }
+      length = value;
+      received = 0;
+      crc = crc16Update(crc, value);
+      state = length > 0 ? READ_PAYLOAD : READ_CRC_LOW;
+      return false;
+
+    case READ_PAYLOAD:
+      payload[received++] = value;
+      crc = crc16Update(crc, value);
+      if (received == length) {
+        state = READ_CRC_LOW;
+      }
+      return false;
+
+    case READ_CRC_LOW:
+      crcLow = value;
+      state = READ_CRC_HIGH;
+      return false;
+
+    case READ_CRC_HIGH:
+      state = WAIT_SYNC;
+      if ((crcLow | (uint16_t)value << 8) != crc) {
+        errors++;
+        return false;
+      }
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,56 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#include <stdint.h>
+#include "Frame.h"
+
+#define FRAME_PARSER_SIZE 40 // Longest payload accepted, the buffer is kept in RAM
+
+/**
+ * Incremental parser for frames written by writeFrame()
+ *
+ * Bytes are fed one at a time as they arrive, nothing is allocated and
+ * nothing waits for the rest of a frame. A frame that is too long or has
+ * a bad CRC is dropped and counted, the parser then looks for the next
+ * FRAME_SYNC. The sender finds out from the missing reply and retries.
+ */
+class FrameParser {
+public:
+  /**
+   * Process a received byte
+   * @return true if it completed a frame with a good CRC
+   */
+  bool feed(uint8_t value);
+
+  /**
+   * Drop a partly received frame
+   */
+  void reset() { state = WAIT_SYNC; }
+
+  /**
+   * Check whether the parser is between frames
+   * A byte other than FRAME_SYNC received now is not part of a frame.
+   */
+  bool isIdle() const { return state == WAIT_SYNC; }
+
+  // The last complete frame, valid until the next call of feed()
+  uint8_t getType() const { return type; }
+  uint8_t getLength() const { return length; }
+  const uint8_t* getPayload() const { return payload; }
+
+  uint16_t getErrors() const { return errors; }
+
+private:
+  enum State : uint8_t { WAIT_SYNC, READ_TYPE, READ_LENGTH, READ_PAYLOAD, READ_CRC_LOW, READ_CRC_HIGH };
+
+  State state = WAIT_SYNC;
+  uint8_t type = 0;
+  uint8_t length = 0;
+  uint8_t received = 0;
+  uint16_t crc = 0;
+  uint8_t crcLow = 0;
+  uint16_t errors = 0;
+  uint8_t payload[FRAME_PARSER_SIZE];
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef FRAME_TYPES_H
+#define FRAME_TYPES_H
+
+// Frame types of the serial protocol, shared by the firmware and host tools.
+// Commands go to the lock, each is answered with a frame of its type | FRAME_REPLY
+// whose payload starts with a FrameStatus. Multi-byte fields are little endian.
+
+#define FRAME_CMD_SET_CLOCK 0x01   // Unix time (4)
+#define FRAME_CMD_SET_TIMEZONE 0x02 // Offset in half-hours (1, signed, -24 to 28)
+#define FRAME_CMD_LOAD_SECRET 0x03  // User (1, 1-32), secret (1-20), no secret removes the user
+#define FRAME_CMD_GET_STATS 0x04    // Reply: FrameStatus and the fields of FRAME_STATS_SIZE
+#define FRAME_CMD_DUMP_LOG 0x05     // Reply: FrameStatus, then the FRAME_LOG_* frames
+#define FRAME_CMD_LOAD_SECRET_BASE32 0x06 // User (1, 1-32), secret in base32 (up to 39 characters, spaces and dashes skipped)
+
+#define FRAME_LOG_START 0x10  // Payload: record count, capacity and dropped records, 2 bytes each
+#define FRAME_LOG_RECORD 0x11 // Payload: one audit log record, oldest first
+#define FRAME_LOG_END 0x12    // Payload: the number of records sent, 2 bytes
+
+#define FRAME_REPLY 0x80
+
+// Stats reply after the status: code index hits (4) and misses (4), clock
+// drift in 1/8 steps (1, signed), RTC time (4), audit log records (2) and
+// dropped records (2), dropped key presses (1), minimum free SRAM (2)
+#define FRAME_STATS_SIZE 21
+
+/**
+ * Result of a command, the first byte of its reply
+ */
+enum FrameStatus : uint8_t {
+  FRAME_OK = 0,
+  FRAME_BAD_LENGTH = 1, // The payload is too short or too long for the command
+  FRAME_BAD_VALUE = 2,  // A field is out of range
+  FRAME_UNKNOWN = 3,    // No such command
+  FRAME_FAILED = 4      // The hardware did not do it
+};
+
+#endif
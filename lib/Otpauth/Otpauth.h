@@ -0,0 +1,96 @@
+#ifndef OTPAUTH_H
+#define OTPAUTH_H
+
+#include <stdint.h>
+#include <Base32.h>
+
+#define OTPAUTH_URI_MAX_LENGTH 128 // Longest otpauth URI that can be built, including the null terminator
+#define OTPAUTH_SECRET_MAX_LENGTH 40 // Base32 characters for secrets up to 25 bytes, including the null terminator
+
+/**
+ * An otpauth URI held by value so it can be built at compile time
+ * length is 0 and text is empty if the URI did not fit in OTPAUTH_URI_MAX_LENGTH.
+ */
+struct OtpauthUri {
+  char text[OTPAUTH_URI_MAX_LENGTH];
+  uint8_t length;
+};
+
+/**
+ * Append a string to an otpauth URI
+ * @param uri The URI to append to
+ * @param text The null terminated string to append
+ * @return false if the string did not fit
+ */
+constexpr bool otpauthAppend(OtpauthUri& uri, const char* text) {
+  for (int i = 0; text[i] != 0; i++) {
+    if (uri.length >= OTPAUTH_URI_MAX_LENGTH - 1) {
+      return false;
+    }
+    uri.text[uri.length++] = text[i];
+  }
+  uri.text[uri.length] = 0;
+  return true;
+}
+
+/**
+ * Check whether a character may appear in a URI as it is (RFC 3986 unreserved)
+ */
+constexpr bool otpauthUnreserved(char c) {
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' ||
+         c == '_' || c == '~';
+}
+
+/**
+ * Append a string to an otpauth URI, percent-encoding what is not unreserved
+ * @param uri The URI to append to
+ * @param text The null terminated string to append
+ * @param keep A character kept as it is, 0 for none
+ * @return false if the string did not fit
+ */
+constexpr bool otpauthAppendEncoded(OtpauthUri& uri, const char* text, char keep) {
+  for (int i = 0; text[i] != 0; i++) {
+    char c = text[i];
+    if (otpauthUnreserved(c) || (keep != 0 && c == keep)) {
+      char plain[2] = {c, 0};
+      if (!otpauthAppend(uri, plain)) {
+        return false;
+      }
+    } else {
+      const char hex[] = "0123456789ABCDEF";
+      char encoded[4] = {'%', hex[(uint8_t)c >> 4], hex[(uint8_t)c & 0x0F], 0};
+      if (!otpauthAppend(uri, encoded)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Build the otpauth URI understood by Google Authenticator and similar apps
+ * Format: otpauth://totp/Label?secret=SECRET&issuer=Issuer
+ * The label and issuer are percent-encoded, except the ':' that separates
+ * the issuer prefix of the label.
+ * @param key The shared secret
+ * @param keyLength The length of the shared secret in bytes
+ * @param label The account label, e.g. "Door:Lock"
+ * @param issuer The issuer shown by the app
+ * @return The URI, empty with length 0 if it did not fit
+ */
+constexpr OtpauthUri makeOtpauthUri(const uint8_t* key, int keyLength, const char* label, const char* issuer) {
+  OtpauthUri uri{};
+  char secret[OTPAUTH_SECRET_MAX_LENGTH]{};
+  base32Encode(key, keyLength, secret, OTPAUTH_SECRET_MAX_LENGTH); // Convert HMAC key to Base32 for the URI
+
+  bool fits = otpauthAppend(uri, "otpauth://totp/") && otpauthAppendEncoded(uri, label, ':') &&
+              otpauthAppend(uri, "?secret=") && otpauthAppend(uri, secret) &&
+              otpauthAppend(uri, "&issuer=") && otpauthAppendEncoded(uri, issuer, 0);
+  if (!fits) {
+    uri.text[0] = 0;
+    uri.length = 0;
+  }
+  return uri;
+}
+
+#endif
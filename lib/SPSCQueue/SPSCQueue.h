@@ -0,0 +1,61 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+
+/**
+ * Lock-free single-producer single-consumer ring buffer
+ *
+ * Meant to pass items from an interrupt handler to loop() (or the other way
+ * round) without disabling interrupts: the producer only writes head, the
+ * consumer only writes tail, and both are single bytes so they are read and
+ * written atomically on AVR. The indices run freely and wrap at 256, which
+ * is why SIZE must be a power of two no larger than 128.
+ */
+template <typename T, uint8_t SIZE>
+class SPSCQueue {
+  static_assert(SIZE > 0 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two up to 128");
+
+public:
+  /**
+   * Add an item, producer side only
+   * @return false if the queue is full and the item was dropped
+   */
+  bool push(const T& item) {
+    uint8_t currentHead = head;
+    if ((uint8_t)(currentHead - tail) == SIZE) {
+      return false;
+    }
+    buffer[currentHead & (SIZE - 1)] = item;
+    compilerBarrier(); // The item must be stored before it is published
+    head = currentHead + 1;
+    return true;
+  }
+
+  /**
+   * Remove the oldest item, consumer side only
+   * @return false if the queue is empty
+   */
+  bool pop(T& item) {
+    uint8_t currentTail = tail;
+    if (currentTail == head) {
+      return false;
+    }
+    item = buffer[currentTail & (SIZE - 1)];
+    compilerBarrier(); // The item must be copied before its slot is released
+    tail = currentTail + 1;
+    return true;
+  }
+
+  uint8_t count() const { return (uint8_t)(head - tail); }
+  bool isEmpty() const { return head == tail; }
+
+private:
+  static inline void compilerBarrier() { __asm__ __volatile__("" ::: "memory"); }
+
+  T buffer[SIZE];
+  volatile uint8_t head = 0; // Next slot to write, owned by the producer
+  volatile uint8_t tail = 0; // Next slot to read, owned by the consumer
+};
+
+#endif
@@ -0,0 +1,33 @@
+#include "ScreenCompositor.h"
+
+static bool elementsEqual(const ScreenElement& a, const ScreenElement& b) {
+  return a.type == b.type && a.size == b.size && a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h &&
+         a.color == b.color && strcmp(a.text, b.text) == 0;
+}
+
+static bool elementsOverlap(const ScreenElement& a, const ScreenElement& b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+bool screenHasElement(const ScreenElement* elements, uint8_t count, const ScreenElement& element) {
+  ScreenElement other;
+  for (uint8_t i = 0; i < count; i++) {
+    memcpy_P(&other, &elements[i], sizeof(other));
+    if (elementsEqual(other, element)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool screenErasedOverlap(const ScreenElement* elements, uint8_t count, const ScreenElement* other,
+                         uint8_t otherCount, const ScreenElement& element) {
+  ScreenElement erased;
+  for (uint8_t i = 0; i < count; i++) {
+    memcpy_P(&erased, &elements[i], sizeof(erased));
+    if (elementsOverlap(erased, element) && !screenHasElement(other, otherCount, erased)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,167 @@
+#ifndef SCREEN_COMPOSITOR_H
+#define SCREEN_COMPOSITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef memcpy_P
+#define memcpy_P memcpy
+#endif
+#endif
+
+#define SCREEN_TEXT_SIZE 17  // Longest text of an element and the null terminator
+#define SCREEN_CHAR_WIDTH 6  // Size of a character of the built-in font at text size 1, spacing included
+#define SCREEN_CHAR_HEIGHT 8
+
+enum ScreenElementType : uint8_t {
+  SCREEN_TEXT, // Text in the built-in font
+  SCREEN_RECT  // Filled rectangle, in the background color it reserves an area drawn by the firmware
+};
+
+/**
+ * Something a screen shows, with the box it covers
+ */
+struct ScreenElement {
+  ScreenElementType type;
+  uint8_t size;  // Text size, 1 for a rectangle
+  int16_t x;     // Box covered on the screen
+  int16_t y;
+  int16_t w;
+  int16_t h;
+  uint16_t color;
+  char text[SCREEN_TEXT_SIZE]; // Empty for a rectangle
+};
+
+/**
+ * Text centered on a column, a longer text than SCREEN_TEXT_SIZE - 1 does not compile
+ * @param centerX The column the text is centered on
+ * @param y The top of the text
+ */
+constexpr ScreenElement screenText(int16_t centerX, int16_t y, uint8_t size, uint16_t color, const char* text) {
+  ScreenElement element{SCREEN_TEXT, size, 0, y, 0, (int16_t)(SCREEN_CHAR_HEIGHT * size), color, {}};
+  uint8_t length = 0;
+  for (; text[length] != '\0'; length++) {
+    element.text[length] = text[length];
+  }
+  element.w = length * SCREEN_CHAR_WIDTH * size;
+  element.x = centerX - element.w / 2;
+  return element;
+}
+
+constexpr ScreenElement screenRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  return ScreenElement{SCREEN_RECT, 1, x, y, w, h, color, {}};
+}
+
+/**
+ * Check whether a screen has an element, elements are in flash
+ */
+bool screenHasElement(const ScreenElement* elements, uint8_t count, const ScreenElement& element);
+
+/**
+ * Check whether any element of a screen that another screen lacks overlaps an element
+ * These are the elements erased when going from the first screen to the other.
+ */
+bool screenErasedOverlap(const ScreenElement* elements, uint8_t count, const ScreenElement* other,
+                         uint8_t otherCount, const ScreenElement& element);
+
+/**
+ * Draws screens described by tables of elements in flash, and knows which is on glass
+ *
+ * Going from one screen to another only erases the elements that the new
+ * screen lacks and draws the elements that were not there yet (or that an
+ * erased box cut into). Elements the screens share stay as they are, and
+ * so does whatever was drawn into a background colored rectangle the
+ * screens share. Only a screen drawn after invalidate() starts with a clear.
+ * Drawing outside the elements of the screen on glass is not tracked, the
+ * firmware only draws into its rectangles.
+ * @tparam Canvas The display, with the drawing calls of Adafruit_GFX
+ */
+template <typename Canvas>
+class ScreenCompositor {
+public:
+  ScreenCompositor(Canvas& canvas, uint16_t background) : canvas(canvas), background(background) {}
+
+  /**
+   * Show a screen
+   * @param elements The table of the screen, in flash
+   */
+  template <size_t count>
+  void show(const ScreenElement (&elements)[count]) {
+    show(elements, count);
+  }
+
+  void show(const ScreenElement* elements, uint8_t count) {
+    if (elements == shown) {
+      return;
+    }
+
+    ScreenElement element;
+    if (shown == nullptr) {
+      canvas.fillScreen(background);
+    } else {
+      for (uint8_t i = 0; i < shownCount; i++) {
+        memcpy_P(&element, &shown[i], sizeof(element));
+        if (!screenHasElement(elements, count, element)) {
+          canvas.fillRect(element.x, element.y, element.w, element.h, background);
+        }
+      }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+      memcpy_P(&element, &elements[i], sizeof(element));
+      if (shown == nullptr || !screenHasElement(shown, shownCount, element) ||
+          screenErasedOverlap(shown, shownCount, elements, count, element)) {
+        draw(element);
+      }
+    }
+    shown = elements;
+    shownCount = count;
+  }
+
+  /**
+   * Check whether a screen is on glass
+   */
+  template <size_t count>
+  bool isShown(const ScreenElement (&elements)[count]) const {
+    return elements == shown;
+  }
+
+  /**
+   * Forget what is on glass, after something else was drawn over the screen
+   */
+  void invalidate() {
+    shown = nullptr;
+    shownCount = 0;
+  }
+
+private:
+  void draw(const ScreenElement& element) {
+    if (element.type == SCREEN_RECT) {
+      // A background rectangle is already there, it was erased or cleared
+      if (element.color != background) {
+        canvas.fillRect(element.x, element.y, element.w, element.h, element.color);
+      }
+      return;
+    }
+    canvas.setTextSize(element.size);
+    canvas.setTextColor(element.color);
+    canvas.setCursor(element.x, element.y);
+    for (const char* c = element.text; *c != '\0'; c++) {
+      canvas.write((uint8_t)*c);
+    }
+  }
+
+  Canvas& canvas;
+  uint16_t background;
+  const ScreenElement* shown = nullptr; // Table of the screen on glass, nullptr if unknown
+  uint8_t shownCount = 0;
+};
+
+#endif
@@ -0,0 +1,524 @@
+#ifndef STATIC_QRCODE_H
+#define STATIC_QRCODE_H
+
+#include <stdint.h>
+
+/**
+ * Compile-time QR code encoder
+ *
+ * Encodes a string in byte mode into a QR code of a fixed version (1-10)
+ * entirely in constexpr functions, so a QR code whose contents are known at
+ * build time can be generated by the compiler and stored in flash:
+ *
+ *   constexpr QRBitmap<4> qr PROGMEM = qrEncodeText<4>("hello", QR_ECC_LOW);
+ *
+ * The module bitmap uses the same layout as the ricmoo QRCode library: bits
+ * are packed row by row, most significant bit first, and a set bit is a dark
+ * module. The encoder can also be called at runtime on the host.
+ */
+
+// Error correction levels (same numbering as the ricmoo QRCode library)
+enum QREcc : uint8_t {
+  QR_ECC_LOW = 0,
+  QR_ECC_MEDIUM = 1,
+  QR_ECC_QUARTILE = 2,
+  QR_ECC_HIGH = 3
+};
+
+#define QR_MIN_VERSION 1
+#define QR_MAX_VERSION 10
+#define QR_MAX_BLOCKS 8          // Most error correction blocks used by versions 1-10
+#define QR_MAX_BLOCK_ECC_LENGTH 30 // Most error correction codewords per block in versions 1-10
+
+/**
+ * A QR code module bitmap
+ * valid is false if the text did not fit in the requested version.
+ */
+template <uint8_t VERSION>
+struct QRBitmap {
+  static constexpr uint8_t size = 17 + 4 * VERSION;
+
+  bool valid;
+  uint8_t mask;
+  uint8_t modules[(size * size + 7) / 8];
+
+  /**
+   * Get a module of a QR code held in RAM
+   * @param x The column of the module
+   * @param y The row of the module
+   * @return true if the module is dark
+   */
+  constexpr bool getModule(uint8_t x, uint8_t y) const {
+    uint16_t offset = y * size + x;
+    return (modules[offset >> 3] >> (7 - (offset & 7))) & 1;
+  }
+};
+
+namespace qr_detail {
+
+// Error correction codewords per block, indexed by [ecc][version - 1]
+constexpr uint8_t eccCodewordsPerBlock[4][QR_MAX_VERSION] = {
+  { 7, 10, 15, 20, 26, 18, 20, 24, 30, 18},  // Low
+  {10, 16, 26, 18, 24, 16, 18, 22, 22, 26},  // Medium
+  {13, 22, 18, 26, 18, 24, 18, 22, 20, 24},  // Quartile
+  {17, 28, 22, 16, 22, 28, 26, 26, 24, 28},  // High
+};
+
+// Error correction blocks, indexed by [ecc][version - 1]
+constexpr uint8_t errorCorrectionBlocks[4][QR_MAX_VERSION] = {
+  {1, 1, 1, 1, 1, 2, 2, 2, 2, 4},  // Low
+  {1, 1, 1, 2, 2, 4, 4, 4, 5, 5},  // Medium
+  {1, 1, 2, 2, 4, 4, 6, 6, 8, 8},  // Quartile
+  {1, 1, 2, 4, 4, 4, 5, 6, 8, 8},  // High
+};
+
+// Error correction level as encoded in the format information
+constexpr uint8_t formatEccBits[4] = {1, 0, 3, 2};
+
+/**
+ * Count the modules available for data and error correction codewords
+ * @param version The QR code version
+ * @return The number of modules
+ */
+constexpr uint16_t rawDataModules(uint8_t version) {
+  uint16_t result = (16 * version + 128) * version + 64;
+  if (version >= 2) {
+    uint8_t numAlign = version / 7 + 2;
+    result -= (25 * numAlign - 10) * numAlign - 55;
+    if (version >= 7) {
+      result -= 36;
+    }
+  }
+  return result;
+}
+
+/**
+ * Multiply two elements of GF(2^8) modulo the QR code polynomial 0x11D
+ */
+constexpr uint8_t gfMultiply(uint8_t x, uint8_t y) {
+  uint16_t z = 0;
+  for (int8_t i = 7; i >= 0; i--) {
+    z = (z << 1) ^ ((z >> 7) * 0x11D);
+    z ^= ((y >> i) & 1) * x;
+  }
+  return (uint8_t)z;
+}
+
+constexpr long absDiff(long a, long b) {
+  return a > b ? a - b : b - a;
+}
+
+/**
+ * Working state of the encoder: the module grid and which modules
+ * belong to function patterns (finders, timing, alignment, format)
+ */
+template <uint8_t VERSION>
+class Encoder {
+public:
+  static constexpr uint8_t size = 17 + 4 * VERSION;
+  static constexpr uint16_t totalCodewords = rawDataModules(VERSION) / 8;
+
+  constexpr Encoder() : grid{}, isFunction{}, codewords{}, bitLength(0) {}
+
+  /**
+   * Encode the text into the grid
+   * @return false if the text does not fit
+   */
+  constexpr bool encode(const char* text, QREcc ecc) {
+    uint8_t numBlocks = errorCorrectionBlocks[ecc][VERSION - 1];
+    uint8_t blockEccLength = eccCodewordsPerBlock[ecc][VERSION - 1];
+    uint16_t dataCodewords = totalCodewords - numBlocks * blockEccLength;
+
+    uint16_t textLength = 0;
+    while (text[textLength] != 0) {
+      textLength++;
+    }
+
+    // Byte mode segment: mode indicator, character count, data
+    uint8_t countBits = VERSION < 10 ? 8 : 16;
+    if (4 + countBits + 8UL * textLength > dataCodewords * 8UL) {
+      return false;
+    }
+    appendBits(0x4, 4);
+    appendBits(textLength, countBits);
+    for (uint16_t i = 0; i < textLength; i++) {
+      appendBits((uint8_t)text[i], 8);
+    }
+
+    // Terminator, bit padding to a whole byte, then alternating pad bytes
+    uint16_t capacityBits = dataCodewords * 8;
+    uint16_t terminator = capacityBits - bitLength;
+    appendBits(0, terminator < 4 ? terminator : 4);
+    appendBits(0, (8 - bitLength % 8) % 8);
+    for (uint8_t pad = 0xEC; bitLength < capacityBits; pad ^= 0xEC ^ 0x11) {
+      appendBits(pad, 8);
+    }
+
+    addErrorCorrection(numBlocks, blockEccLength);
+
+    drawFunctionPatterns();
+    drawCodewords();
+    return true;
+  }
+
+  /**
+   * Choose the mask with the lowest penalty and apply it
+   * @return The chosen mask (0-7)
+   */
+  constexpr uint8_t applyBestMask(QREcc ecc) {
+    uint8_t bestMask = 0;
+    long bestPenalty = -1;
+    for (uint8_t mask = 0; mask < 8; mask++) {
+      applyMask(mask);
+      drawFormatBits(ecc, mask);
+      long penalty = penaltyScore();
+      if (bestPenalty < 0 || penalty < bestPenalty) {
+        bestMask = mask;
+        bestPenalty = penalty;
+      }
+      applyMask(mask); // XOR again to undo
+    }
+    applyMask(bestMask);
+    drawFormatBits(ecc, bestMask);
+    return bestMask;
+  }
+
+  /**
+   * Pack the grid into a bitmap, row by row, most significant bit first
+   */
+  constexpr void pack(uint8_t* modules) const {
+    for (uint16_t i = 0; i < (size * size + 7) / 8; i++) {
+      modules[i] = 0;
+    }
+    for (uint8_t y = 0; y < size; y++) {
+      for (uint8_t x = 0; x < size; x++) {
+        uint16_t offset = y * size + x;
+        if (grid[y][x]) {
+          modules[offset >> 3] |= 0x80 >> (offset & 7);
+        }
+      }
+    }
+  }
+
+private:
+  constexpr void appendBits(uint16_t value, uint8_t count) {
+    for (int8_t i = count - 1; i >= 0; i--) {
+      if ((value >> i) & 1) {
+        codewords[bitLength >> 3] |= 0x80 >> (bitLength & 7);
+      }
+      bitLength++;
+    }
+  }
+
+  /**
+   * Split the data codewords into blocks, compute the Reed-Solomon codewords
+   * of each block and interleave everything into codewords
+   */
+  constexpr void addErrorCorrection(uint8_t numBlocks, uint8_t blockEccLength) {
+    uint8_t numShortBlocks = numBlocks - totalCodewords % numBlocks;
+    uint8_t shortBlockDataLength = totalCodewords / numBlocks - blockEccLength;
+
+    // Reed-Solomon generator polynomial, leading 1 coefficient omitted
+    uint8_t divisor[QR_MAX_BLOCK_ECC_LENGTH]{};
+    divisor[blockEccLength - 1] = 1;
+    uint8_t root = 1;
+    for (uint8_t i = 0; i < blockEccLength; i++) {
+      for (uint8_t j = 0; j < blockEccLength; j++) {
+        divisor[j] = gfMultiply(divisor[j], root);
+        if (j + 1 < blockEccLength) {
+          divisor[j] ^= divisor[j + 1];
+        }
+      }
+      root = gfMultiply(root, 0x02);
+    }
+
+    uint8_t ecc[QR_MAX_BLOCKS][QR_MAX_BLOCK_ECC_LENGTH]{};
+    uint8_t data[rawDataModules(VERSION) / 8]{};
+    uint16_t blockStart = 0;
+    for (uint8_t b = 0; b < numBlocks; b++) {
+      uint8_t dataLength = shortBlockDataLength + (b < numShortBlocks ? 0 : 1);
+      for (uint8_t i = 0; i < dataLength; i++) {
+        uint8_t factor = codewords[blockStart + i] ^ ecc[b][0];
+        for (uint8_t j = 0; j + 1 < blockEccLength; j++) {
+          ecc[b][j] = ecc[b][j + 1];
+        }
+        ecc[b][blockEccLength - 1] = 0;
+        for (uint8_t j = 0; j < blockEccLength; j++) {
+          ecc[b][j] ^= gfMultiply(divisor[j], factor);
+        }
+      }
+      blockStart += dataLength;
+    }
+
+    // Interleave the data codewords, then the error correction codewords
+    uint16_t out = 0;
+    for (uint8_t i = 0; i <= shortBlockDataLength; i++) {
+      blockStart = 0;
+      for (uint8_t b = 0; b < numBlocks; b++) {
+        uint8_t dataLength = shortBlockDataLength + (b < numShortBlocks ? 0 : 1);
+        if (i < dataLength) {
+          data[out++] = codewords[blockStart + i];
+        }
+        blockStart += dataLength;
+      }
+    }
+    for (uint8_t i = 0; i < blockEccLength; i++) {
+      for (uint8_t b = 0; b < numBlocks; b++) {
+        data[out++] = ecc[b][i];
+      }
+    }
+    for (uint16_t i = 0; i < totalCodewords; i++) {
+      codewords[i] = data[i];
+    }
+  }
+
+  constexpr void setFunctionModule(uint8_t x, uint8_t y, bool dark) {
+    grid[y][x] = dark;
+    isFunction[y][x] = true;
+  }
+
+  constexpr void drawFinderPattern(int cx, int cy) {
+    for (int dy = -4; dy <= 4; dy++) {
+      for (int dx = -4; dx <= 4; dx++) {
+        int x = cx + dx;
+        int y = cy + dy;
+        if (x >= 0 && x < size && y >= 0 && y < size) {
+          uint8_t dist = absDiff(dx, 0) > absDiff(dy, 0) ? absDiff(dx, 0) : absDiff(dy, 0);
+          setFunctionModule(x, y, dist != 2 && dist != 4);
+        }
+      }
+    }
+  }
+
+  constexpr void drawAlignmentPattern(int cx, int cy) {
+    for (int dy = -2; dy <= 2; dy++) {
+      for (int dx = -2; dx <= 2; dx++) {
+        uint8_t dist = absDiff(dx, 0) > absDiff(dy, 0) ? absDiff(dx, 0) : absDiff(dy, 0);
+        setFunctionModule(cx + dx, cy + dy, dist != 1);
+      }
+    }
+  }
+
+  constexpr void drawFunctionPatterns() {
+    // Timing patterns
+    for (uint8_t i = 0; i < size; i++) {
+      setFunctionModule(6, i, i % 2 == 0);
+      setFunctionModule(i, 6, i % 2 == 0);
+    }
+
+    // Finder patterns with their separators
+    drawFinderPattern(3, 3);
+    drawFinderPattern(size - 4, 3);
+    drawFinderPattern(3, size - 4);
+
+    // Alignment patterns, except where they would overlap the finders
+    if (VERSION >= 2) {
+      uint8_t numAlign = VERSION / 7 + 2;
+      uint8_t step = (VERSION * 4 + numAlign * 2 + 1) / (numAlign * 2 - 2) * 2;
+      uint8_t positions[QR_MAX_VERSION / 7 + 2]{};
+      positions[0] = 6;
+      for (uint8_t i = numAlign - 1, pos = size - 7; i >= 1; i--, pos -= step) {
+        positions[i] = pos;
+      }
+      for (uint8_t i = 0; i < numAlign; i++) {
+        for (uint8_t j = 0; j < numAlign; j++) {
+          bool finderCorner = (i == 0 && j == 0) || (i == 0 && j == numAlign - 1) || (i == numAlign - 1 && j == 0);
+          if (!finderCorner) {
+            drawAlignmentPattern(positions[i], positions[j]);
+          }
+        }
+      }
+    }
+
+    // Reserve the format areas, the real bits are drawn with the mask
+    drawFormatBits(QR_ECC_LOW, 0);
+
+    // Version information for version 7 and up
+    if (VERSION >= 7) {
+      uint32_t rem = VERSION;
+      for (uint8_t i = 0; i < 12; i++) {
+        rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+      }
+      uint32_t bits = (uint32_t)VERSION << 12 | rem;
+      for (uint8_t i = 0; i < 18; i++) {
+        bool bit = (bits >> i) & 1;
+        uint8_t a = size - 11 + i % 3;
+        uint8_t b = i / 3;
+        setFunctionModule(a, b, bit);
+        setFunctionModule(b, a, bit);
+      }
+    }
+  }
+
+  constexpr void drawFormatBits(QREcc ecc, uint8_t mask) {
+    uint16_t data = formatEccBits[ecc] << 3 | mask;
+    uint16_t rem = data;
+    for (uint8_t i = 0; i < 10; i++) {
+      rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    }
+    uint16_t bits = (data << 10 | rem) ^ 0x5412;
+
+    // First copy, around the top left finder
+    for (uint8_t i = 0; i <= 5; i++) {
+      setFunctionModule(8, i, (bits >> i) & 1);
+    }
+    setFunctionModule(8, 7, (bits >> 6) & 1);
+    setFunctionModule(8, 8, (bits >> 7) & 1);
+    setFunctionModule(7, 8, (bits >> 8) & 1);
+    for (uint8_t i = 9; i < 15; i++) {
+      setFunctionModule(14 - i, 8, (bits >> i) & 1);
+    }
+
+    // Second copy, split between the other two finders
+    for (uint8_t i = 0; i < 8; i++) {
+      setFunctionModule(size - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (uint8_t i = 8; i < 15; i++) {
+      setFunctionModule(8, size - 15 + i, (bits >> i) & 1);
+    }
+    setFunctionModule(8, size - 8, true); // Always dark
+  }
+
+  /**
+   * Place the codewords in the zigzag pattern of two-module columns,
+   * skipping function modules
+   */
+  constexpr void drawCodewords() {
+    uint16_t i = 0;
+    for (int right = size - 1; right >= 1; right -= 2) {
+      if (right == 6) {
+        right = 5; // Skip the vertical timing pattern
+      }
+      bool upward = ((right + 1) & 2) == 0;
+      for (uint8_t vert = 0; vert < size; vert++) {
+        for (uint8_t j = 0; j < 2; j++) {
+          uint8_t x = right - j;
+          uint8_t y = upward ? size - 1 - vert : vert;
+          if (!isFunction[y][x] && i < totalCodewords * 8) {
+            grid[y][x] = (codewords[i >> 3] >> (7 - (i & 7))) & 1;
+            i++;
+          }
+        }
+      }
+    }
+  }
+
+  constexpr void applyMask(uint8_t mask) {
+    for (uint8_t y = 0; y < size; y++) {
+      for (uint8_t x = 0; x < size; x++) {
+        bool invert = false;
+        switch (mask) {
+          case 0: invert = (x + y) % 2 == 0; break;
+          case 1: invert = y % 2 == 0; break;
+          case 2: invert = x % 3 == 0; break;
+          case 3: invert = (x + y) % 3 == 0; break;
+          case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+          case 5: invert = x * y % 2 + x * y % 3 == 0; break;
+          case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+          case 7: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+        }
+        if (invert && !isFunction[y][x]) {
+          grid[y][x] ^= 1;
+        }
+      }
+    }
+  }
+
+  constexpr uint8_t module(bool columns, uint8_t line, uint8_t i) const {
+    return columns ? grid[i][line] : grid[line][i];
+  }
+
+  /**
+   * Compute the mask penalty of the grid (ISO 18004 rules N1-N4)
+   */
+  constexpr long penaltyScore() const {
+    long result = 0;
+
+    // N1: runs of five or more modules of the same color, and
+    // N3: 1:1:3:1:1 finder-like patterns with four light modules on one side
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      bool columns = pass == 1;
+      for (uint8_t line = 0; line < size; line++) {
+        uint8_t runLength = 0;
+        for (uint8_t i = 0; i < size; i++) {
+          if (i > 0 && module(columns, line, i) == module(columns, line, i - 1)) {
+            runLength++;
+          } else {
+            if (runLength >= 5) {
+              result += runLength - 2;
+            }
+            runLength = 1;
+          }
+        }
+        if (runLength >= 5) {
+          result += runLength - 2;
+        }
+
+        for (uint8_t i = 0; i + 11 <= size; i++) {
+          const uint8_t finderBefore[11] = {1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0};
+          bool before = true;
+          bool after = true;
+          for (uint8_t k = 0; k < 11; k++) {
+            uint8_t m = module(columns, line, i + k);
+            before = before && m == finderBefore[k];
+            after = after && m == finderBefore[10 - k];
+          }
+          result += (before ? 40 : 0) + (after ? 40 : 0);
+        }
+      }
+    }
+
+    // N2: 2x2 blocks of the same color
+    for (uint8_t y = 0; y + 1 < size; y++) {
+      for (uint8_t x = 0; x + 1 < size; x++) {
+        uint8_t c = grid[y][x];
+        if (c == grid[y][x + 1] && c == grid[y + 1][x] && c == grid[y + 1][x + 1]) {
+          result += 3;
+        }
+      }
+    }
+
+    // N4: balance of dark and light modules
+    long dark = 0;
+    for (uint8_t y = 0; y < size; y++) {
+      for (uint8_t x = 0; x < size; x++) {
+        dark += grid[y][x];
+      }
+    }
+    long total = (long)size * size;
+    long k = (absDiff(dark * 20, total * 10) + total - 1) / total - 1;
+    result += k * 10;
+    return result;
+  }
+
+  uint8_t grid[size][size];
+  uint8_t isFunction[size][size];
+  uint8_t codewords[totalCodewords];
+  uint16_t bitLength;
+};
+
+} // namespace qr_detail
+
+/**
+ * Encode a null terminated string into a QR code in byte mode
+ * @tparam VERSION The QR code version (1-10), the code is VERSION * 4 + 17 modules wide
+ * @param text The text to encode
+ * @param ecc The error correction level
+ * @return The QR code, with valid set to false if the text does not fit
+ */
+template <uint8_t VERSION>
+constexpr QRBitmap<VERSION> qrEncodeText(const char* text, QREcc ecc) {
+  static_assert(VERSION >= QR_MIN_VERSION && VERSION <= QR_MAX_VERSION, "Unsupported QR code version");
+
+  QRBitmap<VERSION> bitmap{};
+  qr_detail::Encoder<VERSION> encoder;
+  if (!encoder.encode(text, ecc)) {
+    return bitmap;
+  }
+  bitmap.mask = encoder.applyBestMask(ecc);
+  encoder.pack(bitmap.modules);
+  bitmap.valid = true;
+  return bitmap;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include "TextFormat.h"
+
+uint8_t formatUnsigned(uint32_t value, char* result) {
+  // Digits come out least significant first, so fill from the end
+  char digits[FORMAT_UNSIGNED_SIZE - 1];
+  uint8_t count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+
+  for (uint8_t i = 0; i < count; i++) {
+    result[i] = digits[count - 1 - i];
+  }
+  result[count] = '\0';
+  return count;
+}
+
+uint8_t formatClock12(uint8_t hour, uint8_t minute, char* result) {
+  uint8_t hour12 = hour % 12;
+  if (hour12 == 0) {
+    hour12 = 12; // 12 AM/PM
+  }
+
+  uint8_t length = 0;
+  if (hour12 >= 10) {
+    result[length++] = '1';
+  }
+  result[length++] = '0' + hour12 % 10;
+  result[length++] = ':';
+  result[length++] = '0' + minute / 10;
+  result[length++] = '0' + minute % 10;
+  result[length++] = hour >= 12 ? 'P' : 'A';
+  result[length++] = 'M';
+  result[length] = '\0';
+  return length;
+}
+
+uint8_t formatClock12Seconds(uint8_t hour, uint8_t minute, uint8_t second, char* result) {
+  // Insert the seconds before AM/PM
+  uint8_t length = formatClock12(hour, minute, result) - 2;
+  result[length++] = ':';
+  result[length++] = '0' + second / 10;
+  result[length++] = '0' + second % 10;
+  result[length++] = hour >= 12 ? 'P' : 'A';
+  result[length++] = 'M';
+  result[length] = '\0';
+  return length;
+}
+
+uint8_t formatHalfHours(int8_t halfHours, char* result) {
+  uint8_t length = 0;
+  if (halfHours > 0) {
+    result[length++] = '+';
+  } else if (halfHours < 0) {
+    result[length++] = '-';
+  }
+
+  uint8_t magnitude = halfHours < 0 ? -halfHours : halfHours;
+  length += formatUnsigned(magnitude / 2, result + length);
+  if (magnitude % 2) {
+    result[length++] = '.';
+    result[length++] = '5';
+    result[length] = '\0';
+  }
+  return length;
+}
+
+uint8_t formatUtcOffset(int8_t halfHours, char* result) {
+  result[0] = 'U';
+  result[1] = 'T';
+  result[2] = 'C';
+  result[3] = '\0';
+  if (halfHours == 0) {
+    return 3;
+  }
+  return 3 + formatHalfHours(halfHours, result + 3);
+}
@@ -0,0 +1,54 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <stdint.h>
+
+#define FORMAT_UNSIGNED_SIZE 11       // Buffer for any uint32_t and the null terminator
+#define FORMAT_CLOCK_SIZE 8           // Buffer for "12:59PM" and the null terminator
+#define FORMAT_CLOCK_SECONDS_SIZE 11  // Buffer for "12:59:59PM" and the null terminator
+#define FORMAT_HALF_HOURS_SIZE 6      // Buffer for "-12.5" and the null terminator
+#define FORMAT_UTC_OFFSET_SIZE 9      // Buffer for "UTC-12.5" and the null terminator
+
+// Integer-only formatting into caller buffers, in place of sprintf and
+// dtostrf, which pull vfprintf and the floating point library into flash.
+// Every function null terminates the result and returns its length.
+
+/**
+ * Format an unsigned number in decimal
+ * @param value The number
+ * @param result Buffer for FORMAT_UNSIGNED_SIZE characters
+ */
+uint8_t formatUnsigned(uint32_t value, char* result);
+
+/**
+ * Format a time of day on a 12 hour clock, e.g. "9:05PM"
+ * @param hour The hour (0-23)
+ * @param minute The minute (0-59)
+ * @param result Buffer for FORMAT_CLOCK_SIZE characters
+ */
+uint8_t formatClock12(uint8_t hour, uint8_t minute, char* result);
+
+/**
+ * Format a time of day with seconds on a 12 hour clock, e.g. "9:05:07PM"
+ * @param hour The hour (0-23)
+ * @param minute The minute (0-59)
+ * @param second The second (0-59)
+ * @param result Buffer for FORMAT_CLOCK_SECONDS_SIZE characters
+ */
+uint8_t formatClock12Seconds(uint8_t hour, uint8_t minute, uint8_t second, char* result);
+
+/**
+ * Format a number of half hours as hours, e.g. "+5.5", "-3" or "0"
+ * @param halfHours The number of half hours (-128 to 127)
+ * @param result Buffer for FORMAT_HALF_HOURS_SIZE characters
+ */
+uint8_t formatHalfHours(int8_t halfHours, char* result);
+
+/**
+ * Format a timezone offset, e.g. "UTC+5.5", "UTC-3" or "UTC"
+ * @param halfHours The offset in half hours
+ * @param result Buffer for FORMAT_UTC_OFFSET_SIZE characters
+ */
+uint8_t formatUtcOffset(int8_t halfHours, char* result);
+
+#endif
@@ -0,0 +1,114 @@
+#include "TotpCodeCache.h"
+
+// A step that is never looked up, marks an empty slot
+#define EMPTY_STEP 0xFFFFFFFFUL
+
+bool TotpCodeCache::update(uint32_t centerStep) {
+  // Consecutive steps map to different slots, so the slots always
+  // hold a window of consecutive steps
+  for (uint8_t i = 0; i < TOTP_CACHE_SLOTS; i++) {
+    uint32_t step = centerStep - TOTP_WINDOW + i;
+    uint8_t slot = step % TOTP_CACHE_SLOTS;
+    if (steps[slot] != step) {
+      steps[slot] = step;
+      nextUser[slot] = 0;
+      counts[slot] = 0;
+    }
+  }
+
+  while (true) {
+    // The user furthest behind, usually every slot is complete or
+    // only the newest one needs work
+    uint8_t user = TOTP_MAX_USERS;
+    for (uint8_t slot = 0; slot < TOTP_CACHE_SLOTS; slot++) {
+      if (nextUser[slot] < user) {
+        user = nextUser[slot];
+      }
+    }
+    if (user == TOTP_MAX_USERS) {
+      return false;
+    }
+
+    TotpEngine engine;
+    bool exists = loadUser(user, engine);
+    for (uint8_t slot = 0; slot < TOTP_CACHE_SLOTS; slot++) {
+      if (nextUser[slot] != user) {
+        continue;
+      }
+      if (exists) {
+        insert(slot, engine.getCodeFromSteps(steps[slot]) << 8 | user);
+      }
+      if (++nextUser[slot] == TOTP_MAX_USERS) {
+        indexedSteps++;
+      }
+    }
+
+    // Skipping an empty user is cheap, keep going until one costs an HMAC
+    if (exists) {
+      return true;
+    }
+  }
+}
+
+uint8_t TotpCodeCache::findUser(uint32_t step, uint32_t code) {
+  uint8_t slot = step % TOTP_CACHE_SLOTS;
+  if (steps[slot] == step && nextUser[slot] == TOTP_MAX_USERS) {
+    hits++;
+
+    // Lower bound of code << 8 in the sorted entries
+    uint8_t low = 0, high = counts[slot];
+    while (low < high) {
+      uint8_t middle = (low + high) / 2;
+      if ((entries[slot][middle] >> 8) < code) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    if (low < counts[slot] && (entries[slot][low] >> 8) == code) {
+      return entries[slot][low] & 0xFF;
+    }
+    return TOTP_NO_USER;
+  }
+
+  // Not indexed yet, compute every user's code
+  misses++;
+  TotpEngine engine;
+  for (uint8_t user = 0; user < TOTP_MAX_USERS; user++) {
+    if (loadUser(user, engine) && engine.getCodeFromSteps(step) == code) {
+      return user;
+    }
+  }
+  return TOTP_NO_USER;
+}
+
+void TotpCodeCache::clear() {
+  for (uint8_t i = 0; i < TOTP_CACHE_SLOTS; i++) {
+    steps[i] = EMPTY_STEP;
+  }
+}
+
+/**
+ * Read a user's secret and compute its HMAC midstates
+ * @return false if there is no such user
+ */
+bool TotpCodeCache::loadUser(uint8_t user, TotpEngine& engine) {
+  uint8_t key[TOTP_MAX_KEY_LENGTH];
+  uint8_t keyLength = readKey(user, key);
+  if (keyLength == 0 || keyLength > TOTP_MAX_KEY_LENGTH) {
+    return false;
+  }
+  engine.begin(key, keyLength);
+  return true;
+}
+
+/**
+ * Insert an entry into a slot, keeping it sorted
+ */
+void TotpCodeCache::insert(uint8_t slot, uint32_t entry) {
+  uint8_t i = counts[slot]++;
+  for (; i > 0 && entries[slot][i - 1] > entry; i--) {
+    entries[slot][i] = entries[slot][i - 1];
+  }
+  entries[slot][i] = entry;
+}
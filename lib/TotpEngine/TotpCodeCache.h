@@ -0,0 +1,93 @@
+#ifndef TOTP_CODE_CACHE_H
+#define TOTP_CODE_CACHE_H
+
+#include <stdint.h>
+#include "TotpEngine.h"
+
+#ifndef TOTP_WINDOW
+#define TOTP_WINDOW 1 // Time steps accepted either side of the expected one
+#endif
+#define TOTP_CACHE_SLOTS (2 * TOTP_WINDOW + 1)
+
+#ifndef TOTP_MAX_USERS
+#define TOTP_MAX_USERS 16 // Each user costs 4 * TOTP_CACHE_SLOTS bytes of RAM
+#endif
+#define TOTP_MAX_KEY_LENGTH 32 // Longest secret a TotpKeyReader may return
+#define TOTP_NO_USER 0xFF
+
+static_assert(TOTP_MAX_USERS < TOTP_NO_USER, "User numbers must fit in a byte");
+
+/**
+ * Reads the secret of a user
+ * @param user The user number (0 to TOTP_MAX_USERS - 1)
+ * @param key Buffer for TOTP_MAX_KEY_LENGTH bytes
+ * @return The length of the secret, 0 if there is no such user
+ */
+typedef uint8_t (*TotpKeyReader)(uint8_t user, uint8_t* key);
+
+/**
+ * Index of every user's TOTP code, keyed by time step
+ *
+ * For each of the TOTP_WINDOW time steps either side of the expected one
+ * the cache holds a sorted array of (code << 8 | user) entries, so an
+ * entered code is resolved to a user with a binary search instead of one
+ * HMAC per user. The secrets stay in EEPROM and the HMAC midstates are not
+ * kept, which would cost 40 bytes of RAM per user.
+ *
+ * The index is built from the idle loop: each update() call reads one user's
+ * secret, computes its midstates and inserts its code into every slot that
+ * still needs it, so loop() never stalls for more than one user. Once the
+ * window is filled only one step is new per TOTP_TIME_STEP, which costs
+ * 4 SHA-1 compressions per user (2 for the midstates, 2 for the code).
+ * Lookups in a step that is not fully indexed yet fall back to computing
+ * every user's code and are counted as misses.
+ *
+ * If two users share a code in the same step the lower user number wins.
+ */
+class TotpCodeCache {
+public:
+  explicit TotpCodeCache(TotpKeyReader readKey) : readKey(readKey) { clear(); }
+
+  /**
+   * Index one more user for the window around a time step
+   * @param centerStep The time step in the middle of the window
+   * @return true if a code had to be computed
+   */
+  bool update(uint32_t centerStep);
+
+  /**
+   * Find the user whose code for a time step matches
+   * @param step The time step
+   * @param code The entered code
+   * @return The user number, or TOTP_NO_USER
+   */
+  uint8_t findUser(uint32_t step, uint32_t code);
+
+  /**
+   * Forget all indexed codes, e.g. after a secret changed
+   */
+  void clear();
+
+  uint32_t getHits() const { return hits; }
+  uint32_t getMisses() const { return misses; }
+
+  /**
+   * Get the number of time steps fully indexed since boot
+   */
+  uint32_t getIndexedSteps() const { return indexedSteps; }
+
+private:
+  bool loadUser(uint8_t user, TotpEngine& engine);
+  void insert(uint8_t slot, uint32_t entry);
+
+  TotpKeyReader readKey;
+  uint32_t steps[TOTP_CACHE_SLOTS];                  // Time step indexed in each slot
+  uint8_t nextUser[TOTP_CACHE_SLOTS];                // First user not indexed yet in each slot
+  uint8_t counts[TOTP_CACHE_SLOTS];                  // Entries in each slot
+  uint32_t entries[TOTP_CACHE_SLOTS][TOTP_MAX_USERS]; // code << 8 | user, ascending
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t indexedSteps = 0;
+};
+
+#endif
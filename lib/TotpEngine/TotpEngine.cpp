@@ -0,0 +1,155 @@
+#include "TotpEngine.h"
+#include <string.h>
+
+static const uint32_t sha1InitialState[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+static inline uint32_t rotateLeft(uint32_t value, uint8_t bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+void sha1Compress(uint32_t state[5], const uint8_t block[SHA1_BLOCK_SIZE]) {
+  // Message schedule kept as a 16-word ring to save RAM
+  uint32_t w[16];
+  for (uint8_t i = 0; i < 16; i++) {
+    w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+           (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+  for (uint8_t i = 0; i < 80; i++) {
+    if (i >= 16) {
+      w[i & 15] = rotateLeft(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+    }
+
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+
+    uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i & 15];
+    e = d;
+    d = c;
+    c = rotateLeft(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+/**
+ * Pad the end of a message and run it through the compression function
+ * @param state The SHA-1 state after all complete blocks
+ * @param data The remaining data, shorter than a block
+ * @param length The length of the remaining data
+ * @param totalLength The length of the whole message in bytes
+ */
+static void sha1FinalBlock(uint32_t state[5], const uint8_t* data, uint8_t length, uint32_t totalLength) {
+  uint8_t block[SHA1_BLOCK_SIZE];
+  memcpy(block, data, length);
+  block[length] = 0x80;
+  memset(block + length + 1, 0, SHA1_BLOCK_SIZE - 1 - length);
+
+  // The length needs the last 8 bytes, if the data is in the way it goes in an extra block
+  if (length >= SHA1_BLOCK_SIZE - 8) {
+    sha1Compress(state, block);
+    memset(block, 0, SHA1_BLOCK_SIZE);
+  }
+
+  // Message length in bits, big endian in the last 8 bytes
+  uint32_t bits = totalLength * 8;
+  block[59] = totalLength >> 29;
+  block[60] = bits >> 24;
+  block[61] = bits >> 16;
+  block[62] = bits >> 8;
+  block[63] = bits;
+
+  sha1Compress(state, block);
+}
+
+/**
+ * Write a SHA-1 state as a big endian digest
+ */
+static void sha1Digest(const uint32_t state[5], uint8_t digest[SHA1_DIGEST_SIZE]) {
+  for (uint8_t i = 0; i < 5; i++) {
+    digest[4 * i] = state[i] >> 24;
+    digest[4 * i + 1] = state[i] >> 16;
+    digest[4 * i + 2] = state[i] >> 8;
+    digest[4 * i + 3] = state[i];
+  }
+}
+
+void TotpEngine::begin(const uint8_t* key, uint8_t keyLength) {
+  uint8_t keyBlock[SHA1_BLOCK_SIZE] = {0};
+
+  if (keyLength > SHA1_BLOCK_SIZE) {
+    // Keys longer than a block are replaced by their digest
+    uint32_t state[5];
+    memcpy(state, sha1InitialState, sizeof(state));
+    uint8_t offset = 0;
+    for (; keyLength - offset >= SHA1_BLOCK_SIZE; offset += SHA1_BLOCK_SIZE) {
+      sha1Compress(state, key + offset);
+    }
+    sha1FinalBlock(state, key + offset, keyLength - offset, keyLength);
+    sha1Digest(state, keyBlock);
+  } else {
+    memcpy(keyBlock, key, keyLength);
+  }
+
+  // Inner midstate: K ^ ipad
+  for (uint8_t i = 0; i < SHA1_BLOCK_SIZE; i++) {
+    keyBlock[i] ^= 0x36;
+  }
+  memcpy(innerState, sha1InitialState, sizeof(innerState));
+  sha1Compress(innerState, keyBlock);
+
+  // Outer midstate: K ^ opad (0x36 ^ 0x6A == 0x5C)
+  for (uint8_t i = 0; i < SHA1_BLOCK_SIZE; i++) {
+    keyBlock[i] ^= 0x36 ^ 0x5C;
+  }
+  memcpy(outerState, sha1InitialState, sizeof(outerState));
+  sha1Compress(outerState, keyBlock);
+}
+
+uint32_t TotpEngine::getCodeFromSteps(uint32_t steps) const {
+  // Inner hash: 8-byte big endian counter after the ipad block
+  uint8_t counter[8] = {0, 0, 0, 0, (uint8_t)(steps >> 24), (uint8_t)(steps >> 16), (uint8_t)(steps >> 8), (uint8_t)steps};
+  uint32_t state[5];
+  memcpy(state, innerState, sizeof(state));
+  sha1FinalBlock(state, counter, sizeof(counter), SHA1_BLOCK_SIZE + sizeof(counter));
+
+  // Outer hash: inner digest after the opad block
+  uint8_t hash[SHA1_DIGEST_SIZE];
+  sha1Digest(state, hash);
+  memcpy(state, outerState, sizeof(state));
+  sha1FinalBlock(state, hash, SHA1_DIGEST_SIZE, SHA1_BLOCK_SIZE + SHA1_DIGEST_SIZE);
+  sha1Digest(state, hash);
+
+  // Dynamic truncation (RFC 4226 section 5.3)
+  uint8_t offset = hash[SHA1_DIGEST_SIZE - 1] & 0x0F;
+  uint32_t truncatedHash = (uint32_t)(hash[offset] & 0x7F) << 24 | (uint32_t)hash[offset + 1] << 16 |
+                           (uint32_t)hash[offset + 2] << 8 | hash[offset + 3];
+  return truncatedHash % TOTP_MODULUS;
+}
+
+void TotpEngine::formatCode(uint32_t code, char* result) {
+  for (int8_t i = TOTP_DIGITS - 1; i >= 0; i--) {
+    result[i] = '0' + code % 10;
+    code /= 10;
+  }
+  result[TOTP_DIGITS] = '\0';
+}
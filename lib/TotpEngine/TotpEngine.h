@@ -0,0 +1,69 @@
+#ifndef TOTP_ENGINE_H
+#define TOTP_ENGINE_H
+
+#include <stdint.h>
+
+#define TOTP_TIME_STEP 30       // Seconds per TOTP code (RFC 6238 default)
+#define TOTP_DIGITS 6           // Digits per code
+#define TOTP_MODULUS 1000000UL  // 10 ^ TOTP_DIGITS
+#define SHA1_BLOCK_SIZE 64
+#define SHA1_DIGEST_SIZE 20
+
+/**
+ * Process one 64-byte block with the SHA-1 compression function
+ * @param state The five 32-bit chaining values, updated in place
+ * @param block The block to process
+ */
+void sha1Compress(uint32_t state[5], const uint8_t block[SHA1_BLOCK_SIZE]);
+
+/**
+ * HOTP/TOTP code generator (RFC 4226 / RFC 6238, HMAC-SHA1, 6 digits)
+ *
+ * HMAC-SHA1(K, m) = SHA1((K ^ opad) || SHA1((K ^ ipad) || m)). The key blocks
+ * K ^ ipad and K ^ opad never change, so begin() runs them through the
+ * compression function once and keeps the two resulting midstates. Every
+ * code then only needs two compressions (the 8-byte counter and the inner
+ * digest, each padded to one block) instead of the four the generic
+ * HMAC-SHA1 of the TOTP library performs.
+ *
+ * Codes are identical to the lucadentella TOTP library: the step counter
+ * is a 32-bit value in the low half of the 64-bit HOTP counter.
+ */
+class TotpEngine {
+public:
+  /**
+   * Precompute the HMAC midstates of a key
+   * @param key The shared secret
+   * @param keyLength The length of the shared secret in bytes
+   */
+  void begin(const uint8_t* key, uint8_t keyLength);
+
+  /**
+   * Compute the HOTP code for a counter value
+   * @param steps The number of time steps since the unix epoch
+   * @return The code (0 to 999999)
+   */
+  uint32_t getCodeFromSteps(uint32_t steps) const;
+
+  /**
+   * Compute the TOTP code for a unix time
+   * @param unixTime The time in seconds since the unix epoch
+   * @return The code (0 to 999999)
+   */
+  uint32_t getCode(uint32_t unixTime) const {
+    return getCodeFromSteps(unixTime / TOTP_TIME_STEP);
+  }
+
+  /**
+   * Format a code as TOTP_DIGITS digits with leading zeros
+   * @param code The code
+   * @param result Buffer for at least TOTP_DIGITS + 1 characters
+   */
+  static void formatCode(uint32_t code, char* result);
+
+private:
+  uint32_t innerState[5]; // SHA-1 state after the K ^ ipad block
+  uint32_t outerState[5]; // SHA-1 state after the K ^ opad block
+};
+
+#endif
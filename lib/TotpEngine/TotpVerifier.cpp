@@ -0,0 +1,40 @@
+#include "TotpVerifier.h"
+
+int8_t TotpVerifier::verify(uint32_t code, uint32_t currentStep, uint8_t& user) {
+  uint32_t expected = expectedStep(currentStep);
+
+  // Try the expected step first, then alternate outwards: 0, -1, +1, -2, +2...
+  for (uint8_t i = 0; i < TOTP_CACHE_SLOTS; i++) {
+    int8_t offset = (i & 1) ? -(int8_t)((i + 1) / 2) : (int8_t)(i / 2);
+    user = cache.findUser(expected + offset, code);
+    if (user == TOTP_NO_USER) {
+      continue;
+    }
+    matches[offset + TOTP_WINDOW]++;
+
+    // Move the estimate a quarter of the way towards the observed offset,
+    // by at least one unit so it does not stall just short of it
+    int8_t observed = driftSteps() + offset;
+    int16_t delta = observed * TOTP_DRIFT_SCALE - drift;
+    int16_t step = delta / 4;
+    if (step == 0 && delta != 0) {
+      step = delta > 0 ? 1 : -1;
+    }
+    setDrift(drift + step);
+
+    return observed;
+  }
+  return TOTP_NO_MATCH;
+}
+
+void TotpVerifier::setDrift(int8_t value) {
+  const int8_t limit = TOTP_MAX_DRIFT_STEPS * TOTP_DRIFT_SCALE;
+  drift = value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+/**
+ * Round the drift estimate to whole time steps
+ */
+int8_t TotpVerifier::driftSteps() const {
+  return (drift >= 0 ? drift + TOTP_DRIFT_SCALE / 2 : drift - TOTP_DRIFT_SCALE / 2) / TOTP_DRIFT_SCALE;
+}
@@ -0,0 +1,75 @@
+#ifndef TOTP_VERIFIER_H
+#define TOTP_VERIFIER_H
+
+#include <stdint.h>
+#include "TotpCodeCache.h"
+
+#define TOTP_NO_MATCH INT8_MIN      // Returned by verify() when no step in the window matches
+#define TOTP_DRIFT_SCALE 8          // The drift estimate is kept in 1/8 time steps
+#define TOTP_MAX_DRIFT_STEPS 4      // Largest correction applied to the expected time step
+
+/**
+ * TOTP verification with a clock skew window and drift learning
+ *
+ * The RTC and the phone that generates the codes drift apart, and users who
+ * type a code near a step boundary are one step off. A code is accepted if
+ * it matches any user's code for a step within TOTP_WINDOW of the expected step, the nearest
+ * steps being tried first. The expected step is the current RTC step
+ * corrected by a drift estimate: every success pulls the estimate a quarter
+ * of the way towards the offset it matched, so a clock that runs steadily
+ * ahead or behind recenters the window instead of needing a wider one.
+ */
+class TotpVerifier {
+public:
+  explicit TotpVerifier(TotpCodeCache& cache) : cache(cache) {}
+
+  /**
+   * Index the codes of the window, call from the idle loop
+   * @param currentStep The current time step of the RTC
+   * @return true if a code had to be computed
+   */
+  bool update(uint32_t currentStep) { return cache.update(expectedStep(currentStep)); }
+
+  /**
+   * Check a code against the window and learn from a match
+   * @param code The entered code
+   * @param currentStep The current time step of the RTC
+   * @param user Receives the user the code belongs to
+   * @return The offset of the matching step from currentStep, or TOTP_NO_MATCH
+   */
+  int8_t verify(uint32_t code, uint32_t currentStep, uint8_t& user);
+
+  /**
+   * Get the drift estimate
+   * @return The offset of the codes from the RTC in 1/TOTP_DRIFT_SCALE steps
+   */
+  int8_t getDrift() const { return drift; }
+  void setDrift(int8_t value);
+
+  /**
+   * Correct an RTC time by the drift estimate
+   * The expected step is this time's step, give or take the rounding of the
+   * estimate to whole steps, and the phones' codes roll over when it does.
+   * @param unixTime The RTC time in seconds
+   * @return The time of the phones in seconds, as far as the estimate goes
+   */
+  uint32_t correctedTime(uint32_t unixTime) const {
+    return unixTime + (int16_t)drift * TOTP_TIME_STEP / TOTP_DRIFT_SCALE;
+  }
+
+  /**
+   * Get the number of successful verifications per offset from the expected step
+   * @param offset The offset (-TOTP_WINDOW to TOTP_WINDOW)
+   */
+  uint16_t getMatches(int8_t offset) const { return matches[offset + TOTP_WINDOW]; }
+
+private:
+  int8_t driftSteps() const;
+  uint32_t expectedStep(uint32_t currentStep) const { return currentStep + driftSteps(); }
+
+  TotpCodeCache& cache;
+  int8_t drift = 0;
+  uint16_t matches[TOTP_CACHE_SLOTS] = {0};
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef BENCH_MARKERS_H
+#define BENCH_MARKERS_H
+
+#include <Arduino.h>
+
+// Registers watched by the simavr harness (tools/bench). The general
+// purpose I/O registers have no side effects and are written with a single
+// OUT instruction, so the markers barely disturb the code being measured.
+#define BENCH_MARKER GPIOR0   // Benchmark boundaries, see below
+#define BENCH_NAME GPIOR1     // Characters of the name of the next benchmark
+#define BENCH_SPI_SINK GPIOR2 // Bytes that would be sent to the display
+
+#define BENCH_MARKER_END 0x00  // The current benchmark stopped
+#define BENCH_MARKER_BEGIN 0x01 // A benchmark named by the preceding BENCH_NAME writes started
+#define BENCH_MARKER_DONE 0xFF // All benchmarks ran
+
+#endif
@@ -0,0 +1,178 @@
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <Base32.h>
+#include <TextFormat.h>
+#include <TotpEngine.h>
+#include <TotpCodeCache.h>
+#include "hal/Clock.h"
+#include "BenchMarkers.h"
+
+// Cycle benchmarks, built into the firmware by the bench env and run at the
+// end of setup() under simavr. Every benchmark is wrapped in markers that
+// the harness in tools/bench turns into exact cycle counts.
+
+// Functions and state of main.cpp
+void displayTOTPQRCode();
+void displayDefaultScreen();
+void displayVerificationResult(bool success);
+uint32_t getLocalTime();
+void updateClock(uint32_t localTime);
+void updateCountdown(uint32_t unixTime);
+extern TotpCodeCache totpCache;
+
+// The shared secret of main.cpp (shTGPxibDo)
+static const uint8_t benchKey[] = {0x73, 0x68, 0x54, 0x47, 0x50, 0x78, 0x69, 0x62, 0x44, 0x6f};
+static const uint32_t benchStep = 1700000010UL / TOTP_TIME_STEP;
+
+static void beginBenchmark(const __FlashStringHelper* name) {
+  PGM_P p = reinterpret_cast<PGM_P>(name);
+  for (char c = pgm_read_byte(p); c != '\0'; c = pgm_read_byte(++p)) {
+    BENCH_NAME = c;
+  }
+  BENCH_MARKER = BENCH_MARKER_BEGIN;
+}
+
+static inline void endBenchmark() {
+  BENCH_MARKER = BENCH_MARKER_END;
+}
+
+/**
+ * Check Base32 against the RFC 4648 section 10 test vectors
+ * @return true if every vector encodes and decodes as expected
+ */
+static bool checkBase32Vectors() {
+  static const char vectors[][2][11] PROGMEM = {
+    {"", ""}, {"f", "MY"}, {"fo", "MZXQ"}, {"foo", "MZXW6"},
+    {"foob", "MZXW6YQ"}, {"fooba", "MZXW6YTB"}, {"foobar", "MZXW6YTBOI"}
+  };
+  for (uint8_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    char text[11], expected[11], encoded[11];
+    uint8_t decoded[10];
+    strcpy_P(text, vectors[i][0]);
+    strcpy_P(expected, vectors[i][1]);
+    int length = strlen(text);
+    if (Base32::encode((const uint8_t*)text, length, encoded, sizeof(encoded)) != (int)strlen(expected) ||
+        strcmp(encoded, expected) != 0 || Base32::decode(expected, decoded, sizeof(decoded)) != length ||
+        memcmp(decoded, text, length) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Copy data through a volatile pointer, so the compiler cannot
+ * evaluate the code being measured at compile time
+ */
+static void launder(uint8_t* result, const uint8_t* data, uint8_t length) {
+  const volatile uint8_t* source = data;
+  for (uint8_t i = 0; i < length; i++) {
+    result[i] = source[i];
+  }
+}
+
+void runBenchmarks() {
+  uint8_t key[sizeof(benchKey)];
+  launder(key, benchKey, sizeof(key));
+  volatile uint32_t step = benchStep;
+  volatile uint32_t sinkCode;
+
+  // Interrupts would add the timer and keypad handlers to the counts
+  noInterrupts();
+
+  // The marker writes themselves, subtracted from every other result
+  beginBenchmark(F("_overhead"));
+  endBenchmark();
+
+  TotpEngine engine;
+  beginBenchmark(F("TotpEngine::begin"));
+  engine.begin(key, sizeof(key));
+  endBenchmark();
+
+  beginBenchmark(F("TotpEngine::getCode"));
+  sinkCode = engine.getCodeFromSteps(step);
+  endBenchmark();
+
+  // A failed check shows up in the results as a benchmark of its own
+  if (!checkBase32Vectors()) {
+    beginBenchmark(F("FAILED Base32 RFC 4648 vectors"));
+    endBenchmark();
+  }
+
+  char encoded[17];
+  beginBenchmark(F("base32Encode"));
+  base32Encode(key, sizeof(key), encoded, sizeof(encoded));
+  endBenchmark();
+
+  beginBenchmark(F("Base32::encode"));
+  Base32::encode(key, sizeof(key), encoded, sizeof(encoded));
+  endBenchmark();
+
+  uint8_t decoded[sizeof(key)];
+  beginBenchmark(F("Base32::decode"));
+  Base32::decode(encoded, decoded, sizeof(decoded));
+  endBenchmark();
+
+  // The integer formatters against the sprintf and dtostrf calls they replaced
+  volatile uint8_t hour = 21;
+  volatile uint8_t minute = 5;
+  volatile int8_t offset = 11;
+  char text[FORMAT_UNSIGNED_SIZE];
+  beginBenchmark(F("formatClock12"));
+  formatClock12(hour, minute, text);
+  endBenchmark();
+
+  beginBenchmark(F("sprintf clock"));
+  sprintf(text, "%d:%02d%s", hour % 12 == 0 ? 12 : hour % 12, minute, hour >= 12 ? "PM" : "AM");
+  endBenchmark();
+
+  beginBenchmark(F("formatUtcOffset"));
+  formatUtcOffset(offset, text);
+  endBenchmark();
+
+  beginBenchmark(F("dtostrf offset"));
+  dtostrf(offset / 2.0, 2, offset % 2 == 0 ? 0 : 1, text);
+  endBenchmark();
+
+  beginBenchmark(F("formatUnsigned"));
+  formatUnsigned(step, text);
+  endBenchmark();
+
+  // One user's codes for a new time step, as loop() does when a step starts
+  totpCache.clear();
+  beginBenchmark(F("TotpCodeCache::update"));
+  totpCache.update(step);
+  endBenchmark();
+
+  beginBenchmark(F("displayTOTPQRCode"));
+  displayTOTPQRCode();
+  endBenchmark();
+
+  // Screen transitions, drawing only what differs between the screens
+  displayDefaultScreen();
+  beginBenchmark(F("displayVerificationResult"));
+  displayVerificationResult(false);
+  endBenchmark();
+
+  beginBenchmark(F("displayDefaultScreen"));
+  displayDefaultScreen();
+  endBenchmark();
+
+  // The clock a second later, one character changes
+  uint32_t clockTime = getLocalTime();
+  beginBenchmark(F("updateClock"));
+  updateClock(clockTime + 1);
+  endBenchmark();
+
+  // The countdown bar a second later, the bar shrinks by one step
+  beginBenchmark(F("updateCountdown"));
+  updateCountdown(rtcClock.now() + 1);
+  endBenchmark();
+
+  (void)sinkCode;
+  BENCH_MARKER = BENCH_MARKER_DONE;
+
+  // Sleeping with interrupts off ends the simulation
+  sleep_enable();
+  sleep_cpu();
+}
@@ -0,0 +1,28 @@
+#include "hal/Clock.h"
+
+#define BENCH_CLOCK_TIME 1700000010UL // There is no RTC under simavr
+
+static uint32_t baseTime = BENCH_CLOCK_TIME;
+static unsigned long baseMillis = 0;
+
+Clock rtcClock;
+
+bool Clock::begin() {
+  return true;
+}
+
+void Clock::update() {
+}
+
+uint32_t Clock::now() {
+  return baseTime + (millis() - baseMillis) / 1000;
+}
+
+void Clock::adjust(uint32_t unixTime) {
+  baseTime = unixTime;
+  baseMillis = millis();
+}
+
+uint32_t Clock::getI2CReadsSavedPerHour() const {
+  return 0;
+}
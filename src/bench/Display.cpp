@@ -0,0 +1,153 @@
+#include "hal/Display.h"
+#include "BenchMarkers.h"
+#include <Adafruit_GFX.h>
+#include <DigitFont.h>
+
+/**
+ * Display for the cycle benchmarks
+ * Draws with the Adafruit_GFX code used on the board, but instead of
+ * waiting on the SPI bus every byte the ST7789 would receive is written to
+ * BENCH_SPI_SINK. The cycles measured are the CPU work only, the harness
+ * counts the sink writes so the bus time can be added for any SPI clock.
+ */
+class SinkDisplay : public Adafruit_GFX {
+public:
+  SinkDisplay() : Adafruit_GFX(DISPLAY_WIDTH, DISPLAY_HEIGHT) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    writeFillRect(x, y, 1, 1, color);
+  }
+
+  void writePixel(int16_t x, int16_t y, uint16_t color) override {
+    writeFillRect(x, y, 1, 1, color);
+  }
+
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    // Clip like Adafruit_SPITFT
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) w = _width - x;
+    if (y + h > _height) h = _height - y;
+    if (w <= 0 || h <= 0) {
+      return;
+    }
+
+    writeAddrWindow(x, y, w, h);
+    writeColor(color, (uint32_t)w * h);
+  }
+
+  /**
+   * Send the commands that open an address window: CASET + 4 bytes, RASET + 4 bytes, RAMWR
+   */
+  void writeAddrWindow(int16_t x, int16_t y, int16_t w, int16_t h) {
+    BENCH_SPI_SINK = 0x2A;
+    BENCH_SPI_SINK = x >> 8;
+    BENCH_SPI_SINK = x;
+    BENCH_SPI_SINK = (x + w - 1) >> 8;
+    BENCH_SPI_SINK = x + w - 1;
+    BENCH_SPI_SINK = 0x2B;
+    BENCH_SPI_SINK = y >> 8;
+    BENCH_SPI_SINK = y;
+    BENCH_SPI_SINK = (y + h - 1) >> 8;
+    BENCH_SPI_SINK = y + h - 1;
+    BENCH_SPI_SINK = 0x2C;
+  }
+
+  /**
+   * Send pixels of one color into the open address window
+   */
+  void writeColor(uint16_t color, uint32_t pixels) {
+    uint8_t high = color >> 8, low = color;
+    for (; pixels > 0; pixels--) {
+      BENCH_SPI_SINK = high;
+      BENCH_SPI_SINK = low;
+    }
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+    writeFillRect(x, y, w, h, color);
+  }
+
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    writeFillRect(x, y, 1, h, color);
+  }
+
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    writeFillRect(x, y, w, 1, color);
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override {
+    writeFillRect(x, y, 1, h, color);
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override {
+    writeFillRect(x, y, w, 1, color);
+  }
+
+  void fillScreen(uint16_t color) override {
+    writeFillRect(0, 0, _width, _height, color);
+  }
+};
+
+static SinkDisplay sink;
+
+Display display;
+
+void Display::begin() {
+}
+
+void Display::fillScreen(uint16_t color) {
+  sink.fillScreen(color);
+}
+
+void Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  sink.fillRect(x, y, w, h, color);
+}
+
+void Display::startWrite() {
+}
+
+void Display::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  sink.writeFillRect(x, y, w, h, color);
+}
+
+void Display::endWrite() {
+}
+
+void Display::setCursor(int16_t x, int16_t y) {
+  sink.setCursor(x, y);
+}
+
+void Display::setTextSize(uint8_t size) {
+  sink.setTextSize(size);
+}
+
+void Display::setTextColor(uint16_t color) {
+  sink.setTextColor(color);
+}
+
+size_t Display::write(uint8_t c) {
+  return sink.write(c);
+}
+
+void Display::drawDigits(int16_t x, int16_t y, const char* text, uint8_t size, uint16_t color, uint16_t background) {
+  int16_t w = DIGIT_FONT_WIDTH * size;
+  int16_t h = DIGIT_FONT_HEIGHT * size;
+  if (x < 0 || y < 0 || y + h > DISPLAY_HEIGHT) {
+    return;
+  }
+  for (; *text != '\0' && x + w <= DISPLAY_WIDTH; text++, x += w) {
+    sink.writeAddrWindow(x, y, w, h);
+    digitFontDraw(sink, digitFontGlyph(*text), size, color, background);
+  }
+}
+
+#ifdef TFT_SPI_STATS
+// The harness counts the sink writes instead
+unsigned long Display::getSpiBytes() const {
+  return 0;
+}
+
+void Display::resetSpiBytes() {
+}
+#endif
@@ -0,0 +1,17 @@
+#include "hal/Fram.h"
+
+// There is no I2C device under simavr, the audit log stays disabled
+
+Fram fram;
+
+bool Fram::begin() {
+  return false;
+}
+
+bool Fram::read(uint16_t, uint8_t*, uint8_t) {
+  return false;
+}
+
+bool Fram::write(uint16_t, const uint8_t*, uint8_t) {
+  return false;
+}
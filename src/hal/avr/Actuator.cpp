@@ -0,0 +1,18 @@
+#include "hal/Actuator.h"
+
+#define SOLENOID_PIN 3 // Pin for the solenoid lock
+
+Actuator solenoid;
+
+void Actuator::begin() {
+  pinMode(SOLENOID_PIN, OUTPUT);
+  digitalWrite(SOLENOID_PIN, LOW); // Ensure solenoid is off at startup
+}
+
+void Actuator::set(bool energized) {
+  digitalWrite(SOLENOID_PIN, energized ? HIGH : LOW);
+}
+
+bool Actuator::isEnergized() const {
+  return digitalRead(SOLENOID_PIN) == HIGH;
+}
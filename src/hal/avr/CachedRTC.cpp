@@ -0,0 +1,108 @@
+#include "CachedRTC.h"
+
+volatile uint32_t CachedRTC::ticks = 0;
+
+void CachedRTC::begin(RTC_DS3231* rtc, uint8_t sqwPin) {
+  this->rtc = rtc;
+
+  // SQW is an open-drain output, the 1 Hz falling edge marks a new second
+  pinMode(sqwPin, INPUT_PULLUP);
+  rtc->writeSqwPinMode(DS3231_SquareWave1Hz);
+  attachInterrupt(digitalPinToInterrupt(sqwPin), onTick, FALLING);
+
+  // Counted with millis() until the first edge, which re-syncs in step
+  squareWaveTicking = false;
+  sync();
+  lastSeenTicks = syncTicks;
+  lastTickMillis = syncMillis;
+}
+
+void CachedRTC::update() {
+  uint32_t currentTicks = readTicks();
+  unsigned long currentMillis = millis();
+
+  if (currentTicks != lastSeenTicks) {
+    lastSeenTicks = currentTicks;
+    lastTickMillis = currentMillis;
+    if (!squareWaveTicking) {
+      // Square wave (re)appeared, restart counting from a fresh read
+      squareWaveTicking = true;
+      resyncOnTick = false;
+      sync();
+    } else if (resyncOnTick) {
+      // First edge after adjust()
+      resyncOnTick = false;
+      sync();
+    } else if (currentTicks - syncTicks >= RTC_RESYNC_INTERVAL) {
+      // Re-sync right after an edge so the read cannot straddle the next one
+      sync();
+      Serial.print(F("RTC re-synced, I2C reads saved per hour: "));
+      Serial.println(getI2CReadsSavedPerHour());
+    }
+  } else if (squareWaveTicking && currentMillis - lastTickMillis > RTC_TICK_TIMEOUT) {
+    Serial.println(F("RTC square wave lost, counting with millis()"));
+    squareWaveTicking = false;
+    sync();
+  } else if (!squareWaveTicking && currentMillis - syncMillis >= RTC_FALLBACK_RESYNC_INTERVAL * 1000UL) {
+    sync();
+  }
+}
+
+uint32_t CachedRTC::now() {
+  cachedReads++;
+  if (squareWaveTicking) {
+    return syncTime + (readTicks() - syncTicks);
+  }
+  return syncTime + (millis() - syncMillis) / 1000;
+}
+
+void CachedRTC::adjust(uint32_t unixTime) {
+  rtc->adjust(DateTime(unixTime));
+  sync();
+  // The read may be anywhere in the 1 Hz period, read again right after the next edge
+  resyncOnTick = true;
+}
+
+uint32_t CachedRTC::getI2CReadsSavedPerHour() const {
+  uint32_t elapsedSeconds = millis() / 1000;
+  if (elapsedSeconds == 0 || cachedReads < i2cReads) {
+    return 0;
+  }
+  uint32_t saved = cachedReads - i2cReads;
+  if (saved <= 0xFFFFFFFFUL / 3600) {
+    return saved * 3600 / elapsedSeconds;
+  }
+  // Past a million saved reads the count times 3600 no longer fits, scale per minute instead
+  uint32_t elapsedMinutes = elapsedSeconds / 60;
+  if (elapsedMinutes == 0) {
+    return saved / elapsedSeconds * 3600;
+  }
+  return saved / elapsedMinutes * 60;
+}
+
+void CachedRTC::sync() {
+  DateTime current = rtc->now();
+  i2cReads++;
+
+  syncTime = current.unixtime();
+  syncTicks = readTicks();
+  syncMillis = millis();
+}
+
+/**
+ * Read the tick counter, which the interrupt updates
+ * one byte at a time, with interrupts disabled
+ */
+uint32_t CachedRTC::readTicks() {
+  noInterrupts();
+  uint32_t value = ticks;
+  interrupts();
+  return value;
+}
+
+/**
+ * Square wave interrupt handler, one call per second
+ */
+void CachedRTC::onTick() {
+  ticks++;
+}
@@ -0,0 +1,81 @@
+#ifndef CACHED_RTC_H
+#define CACHED_RTC_H
+
+#include <Arduino.h>
+#include "RTClib.h"
+
+#define RTC_RESYNC_INTERVAL 3600         // Seconds between I2C re-syncs while the square wave is ticking
+#define RTC_FALLBACK_RESYNC_INTERVAL 60  // Seconds between I2C re-syncs when counting with millis() instead
+#define RTC_TICK_TIMEOUT 1500            // Milliseconds without a square wave tick before falling back to millis()
+
+/**
+ * DS3231 time source with a cached unix time
+ *
+ * The DS3231 square-wave output is set to 1 Hz and wired to an interrupt
+ * pin, every falling edge adds one second to the cached time. The time is
+ * only read over I2C at begin(), every RTC_RESYNC_INTERVAL seconds and
+ * after adjust(), so now() costs no bus traffic. If the square wave is not
+ * wired or stops, seconds are counted with millis() and the time is
+ * re-synced every RTC_FALLBACK_RESYNC_INTERVAL seconds instead.
+ */
+class CachedRTC {
+public:
+  /**
+   * Start the time source
+   * Does not wait for the square wave, seconds are counted with millis()
+   * until update() sees the first edge and re-syncs right after it.
+   * @param rtc The DS3231, rtc.begin() must have succeeded
+   * @param sqwPin The interrupt capable pin wired to the DS3231 SQW output
+   */
+  void begin(RTC_DS3231* rtc, uint8_t sqwPin);
+
+  /**
+   * Re-sync from the RTC when due, call this from loop()
+   */
+  void update();
+
+  /**
+   * Get the current time without touching the I2C bus
+   * @return The unix time in seconds
+   */
+  uint32_t now();
+
+  /**
+   * Set the RTC and the cached time
+   * Does not wait for the square wave, update() reads the time again right
+   * after the next edge.
+   * @param unixTime The new unix time in seconds
+   */
+  void adjust(uint32_t unixTime);
+
+  uint32_t getI2CReads() const { return i2cReads; }
+  uint32_t getCachedReads() const { return cachedReads; }
+
+  /**
+   * Estimate the I2C transactions saved per hour compared to reading
+   * the RTC on every call to now()
+   */
+  uint32_t getI2CReadsSavedPerHour() const;
+
+  bool isSquareWaveTicking() const { return squareWaveTicking; }
+
+private:
+  void sync();
+  static uint32_t readTicks();
+  static void onTick();
+
+  RTC_DS3231* rtc = nullptr;
+  uint32_t syncTime = 0;             // Unix time read at the last sync
+  uint32_t syncTicks = 0;            // Square wave ticks counted at the last sync
+  unsigned long syncMillis = 0;      // millis() at the last sync
+  uint32_t lastSeenTicks = 0;        // Ticks seen by the previous update()
+  unsigned long lastTickMillis = 0;  // millis() when update() last saw a new tick
+  bool squareWaveTicking = false;
+  bool resyncOnTick = false;         // adjust() read the RTC away from an edge
+  uint32_t i2cReads = 0;
+  uint32_t cachedReads = 0;
+
+  static volatile uint32_t ticks;    // Falling edges of the square wave, counted by onTick()
+};
+
+#endif
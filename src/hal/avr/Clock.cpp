@@ -0,0 +1,33 @@
+#include "hal/Clock.h"
+#include "CachedRTC.h"
+
+#define RTC_SQW_PIN 2  // Pin wired to the DS3231 SQW output (must support interrupts)
+
+static RTC_DS3231 rtc;
+static CachedRTC cachedRTC; // Cached time from the RTC, read this instead of rtc.now()
+
+Clock rtcClock;
+
+bool Clock::begin() {
+  if (!rtc.begin()) {
+    return false;
+  }
+  cachedRTC.begin(&rtc, RTC_SQW_PIN);
+  return true;
+}
+
+void Clock::update() {
+  cachedRTC.update();
+}
+
+uint32_t Clock::now() {
+  return cachedRTC.now();
+}
+
+void Clock::adjust(uint32_t unixTime) {
+  cachedRTC.adjust(unixTime);
+}
+
+uint32_t Clock::getI2CReadsSavedPerHour() const {
+  return cachedRTC.getI2CReadsSavedPerHour();
+}
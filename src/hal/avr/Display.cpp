@@ -0,0 +1,110 @@
+#include "hal/Display.h"
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7789.h>
+#include <DigitFont.h>
+#include <SPI.h>
+
+// Define ST7789 display pin connection
+#define TFT_CS     10
+#define TFT_RST     8
+#define TFT_DC      9
+
+#ifdef TFT_SPI_STATS
+/**
+ * ST7789 driver that counts the bytes it sends over SPI
+ * Every drawing primitive of Adafruit_SPITFT opens an address window and then
+ * streams w * h 16-bit pixels into it, so the traffic can be counted in one place.
+ */
+class CountingST7789 : public Adafruit_ST7789 {
+public:
+  CountingST7789(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST7789(cs, dc, rst) {}
+
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+    // CASET + 4 bytes, RASET + 4 bytes, RAMWR, then 2 bytes per pixel
+    spiBytes += 11 + 2UL * w * h;
+    Adafruit_ST7789::setAddrWindow(x, y, w, h);
+  }
+
+  unsigned long spiBytes = 0;
+};
+
+static CountingST7789 tft = CountingST7789(TFT_CS, TFT_DC, TFT_RST);
+
+unsigned long Display::getSpiBytes() const {
+  return tft.spiBytes;
+}
+
+void Display::resetSpiBytes() {
+  tft.spiBytes = 0;
+}
+#else
+static Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+#endif
+
+Display display;
+
+void Display::begin() {
+  tft.init(DISPLAY_WIDTH, DISPLAY_HEIGHT, SPI_MODE3);
+  tft.setRotation(2);
+}
+
+void Display::fillScreen(uint16_t color) {
+  tft.fillScreen(color);
+}
+
+void Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  tft.fillRect(x, y, w, h, color);
+}
+
+void Display::startWrite() {
+  tft.startWrite();
+}
+
+void Display::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  tft.writeFillRect(x, y, w, h, color);
+}
+
+void Display::endWrite() {
+  tft.endWrite();
+}
+
+void Display::setCursor(int16_t x, int16_t y) {
+  tft.setCursor(x, y);
+}
+
+void Display::setTextSize(uint8_t size) {
+  tft.setTextSize(size);
+}
+
+void Display::setTextColor(uint16_t color) {
+  tft.setTextColor(color);
+}
+
+size_t Display::write(uint8_t c) {
+  return tft.write(c);
+}
+
+/**
+ * Sends the runs of a glyph into the open address window
+ */
+struct TftRuns {
+  void writeColor(uint16_t color, uint16_t count) {
+    tft.writeColor(color, count);
+  }
+};
+
+void Display::drawDigits(int16_t x, int16_t y, const char* text, uint8_t size, uint16_t color, uint16_t background) {
+  int16_t w = DIGIT_FONT_WIDTH * size;
+  int16_t h = DIGIT_FONT_HEIGHT * size;
+  if (x < 0 || y < 0 || y + h > DISPLAY_HEIGHT) {
+    return;
+  }
+
+  TftRuns runs;
+  tft.startWrite();
+  for (; *text != '\0' && x + w <= DISPLAY_WIDTH; text++, x += w) {
+    tft.setAddrWindow(x, y, w, h);
+    digitFontDraw(runs, digitFontGlyph(*text), size, color, background);
+  }
+  tft.endWrite();
+}
@@ -0,0 +1,48 @@
+#include "hal/Fram.h"
+#include <Wire.h>
+
+#define FRAM_I2C_ADDRESS 0x50  // MB85RC256V with A0-A2 low
+#define FRAM_CHUNK 30          // Data bytes per transaction, the Wire buffer also holds the address
+
+Fram fram;
+
+bool Fram::begin() {
+  Wire.begin();
+  Wire.beginTransmission(FRAM_I2C_ADDRESS);
+  return Wire.endTransmission() == 0;
+}
+
+bool Fram::read(uint16_t address, uint8_t* data, uint8_t length) {
+  while (length > 0) {
+    uint8_t chunk = length < FRAM_CHUNK ? length : FRAM_CHUNK;
+    Wire.beginTransmission(FRAM_I2C_ADDRESS);
+    Wire.write((uint8_t)(address >> 8));
+    Wire.write((uint8_t)address);
+    if (Wire.endTransmission(false) != 0 || Wire.requestFrom((uint8_t)FRAM_I2C_ADDRESS, chunk) != chunk) {
+      return false;
+    }
+    for (uint8_t i = 0; i < chunk; i++) {
+      *data++ = Wire.read();
+    }
+    address += chunk;
+    length -= chunk;
+  }
+  return true;
+}
+
+bool Fram::write(uint16_t address, const uint8_t* data, uint8_t length) {
+  while (length > 0) {
+    uint8_t chunk = length < FRAM_CHUNK ? length : FRAM_CHUNK;
+    Wire.beginTransmission(FRAM_I2C_ADDRESS);
+    Wire.write((uint8_t)(address >> 8));
+    Wire.write((uint8_t)address);
+    Wire.write(data, chunk);
+    if (Wire.endTransmission() != 0) {
+      return false;
+    }
+    data += chunk;
+    address += chunk;
+    length -= chunk;
+  }
+  return true;
+}
@@ -0,0 +1,24 @@
+#include "hal/Keypad.h"
+#include "KeypadSampler.h"
+
+// Define Analog Pin for keypad
+#define KEYPAD_PIN A0
+
+// Calibrated thresholds for the keypad (see the OnePinKeypad calibration example)
+static const int myThresholds[KEYPAD_KEYS] = {6, 84, 152, 207, 252, 297, 337, 373, 400, 430, 457, 482, 501, 522, 542, 560};
+
+static KeypadSampler sampler;
+
+Keypad keypad;
+
+void Keypad::begin() {
+  sampler.begin(KEYPAD_PIN, myThresholds);
+}
+
+bool Keypad::readEvent(KeyEvent& event) {
+  return sampler.readEvent(event);
+}
+
+uint8_t Keypad::getDroppedEvents() const {
+  return sampler.getDroppedEvents();
+}
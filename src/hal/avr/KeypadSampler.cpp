@@ -0,0 +1,92 @@
+#include "KeypadSampler.h"
+
+#define NO_KEY '\0'
+
+// Keys in the order of the OnePinKeypad thresholds
+static const char keypadKeys[KEYPAD_KEYS] = {
+  '1', '2', '3', 'A',
+  '4', '5', '6', 'B',
+  '7', '8', '9', 'C',
+  '*', '0', '#', 'D'
+};
+
+int KeypadSampler::upperBounds[KEYPAD_KEYS];
+char KeypadSampler::candidateKey = NO_KEY;
+unsigned long KeypadSampler::candidateSince = 0;
+uint8_t KeypadSampler::stableSamples = 0;
+char KeypadSampler::debouncedKey = NO_KEY;
+volatile uint8_t KeypadSampler::droppedEvents = 0;
+SPSCQueue<KeyEvent, KEYPAD_QUEUE_SIZE> KeypadSampler::events;
+
+void KeypadSampler::begin(uint8_t pin, const int* thresholds) {
+  // A reading belongs to the key whose threshold is nearest, anything more
+  // than half a step above the last threshold means no key is pressed
+  for (uint8_t i = 0; i < KEYPAD_KEYS - 1; i++) {
+    upperBounds[i] = (thresholds[i] + thresholds[i + 1]) / 2;
+  }
+  upperBounds[KEYPAD_KEYS - 1] = thresholds[KEYPAD_KEYS - 1] +
+                                 (thresholds[KEYPAD_KEYS - 1] - thresholds[KEYPAD_KEYS - 2]) / 2;
+
+  noInterrupts();
+
+  // ADC on the keypad pin against AVcc, 125 kHz ADC clock (104 us per conversion)
+  uint8_t channel = pin >= A0 ? pin - A0 : pin;
+  ADMUX = _BV(REFS0) | (channel & 0x07);
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  ADCSRA |= _BV(ADSC);
+
+  // Timer2 in CTC mode, 16 MHz / 64 / 250 = 1 kHz
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22);
+  OCR2A = 249;
+  TCNT2 = 0;
+  TIMSK2 = _BV(OCIE2A);
+
+  interrupts();
+}
+
+bool KeypadSampler::readEvent(KeyEvent& event) {
+  return events.pop(event);
+}
+
+void KeypadSampler::sample(int value) {
+  char key = classify(value);
+
+  if (key != candidateKey) {
+    candidateKey = key;
+    candidateSince = millis();
+    stableSamples = 0;
+    return;
+  }
+
+  if (stableSamples < KEYPAD_DEBOUNCE_SAMPLES) {
+    stableSamples++;
+    return;
+  }
+
+  if (key != debouncedKey) {
+    debouncedKey = key;
+    if (key != NO_KEY && !events.push(KeyEvent{key, candidateSince})) {
+      droppedEvents++;
+    }
+  }
+}
+
+char KeypadSampler::classify(int value) {
+  for (uint8_t i = 0; i < KEYPAD_KEYS; i++) {
+    if (value < upperBounds[i]) {
+      return keypadKeys[i];
+    }
+  }
+  return NO_KEY;
+}
+
+/**
+ * Keypad sampling interrupt, every millisecond
+ * The conversion started on the previous tick has long finished.
+ */
+ISR(TIMER2_COMPA_vect) {
+  int value = ADC;
+  ADCSRA |= _BV(ADSC);
+  KeypadSampler::sample(value);
+}
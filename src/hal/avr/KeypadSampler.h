@@ -0,0 +1,61 @@
+#ifndef KEYPAD_SAMPLER_H
+#define KEYPAD_SAMPLER_H
+
+#include <Arduino.h>
+#include <SPSCQueue.h>
+#include "hal/Keypad.h"
+
+#define KEYPAD_KEYS 16
+#define KEYPAD_DEBOUNCE_SAMPLES 20  // Identical 1 ms samples needed before a change is accepted
+#define KEYPAD_QUEUE_SIZE 8         // Key events buffered between two passes of loop()
+
+/**
+ * Background sampler for the one pin resistor-ladder keypad
+ *
+ * Timer2 interrupts every millisecond. Each interrupt reads the ADC
+ * conversion started by the previous one and starts the next, so sampling
+ * never blocks. Readings are mapped to keys with the OnePinKeypad calibrated
+ * thresholds, debounced over KEYPAD_DEBOUNCE_SAMPLES samples, and every
+ * press is pushed as a timestamped KeyEvent into a lock-free queue that
+ * loop() drains with readEvent(). Keys pressed while loop() is busy, for
+ * example redrawing the display, are therefore not lost.
+ */
+class KeypadSampler {
+public:
+  /**
+   * Start sampling, this takes over Timer2 and the ADC
+   * @param pin The analog pin the keypad is connected to
+   * @param thresholds The 16 calibrated OnePinKeypad readings, in ascending order
+   */
+  void begin(uint8_t pin, const int* thresholds);
+
+  /**
+   * Get the next key press without blocking
+   * @param event Receives the key press
+   * @return false if no key was pressed
+   */
+  bool readEvent(KeyEvent& event);
+
+  /**
+   * Get the number of key presses dropped because the queue was full
+   */
+  uint8_t getDroppedEvents() const { return droppedEvents; }
+
+  /**
+   * Process one ADC reading, called from the Timer2 interrupt
+   */
+  static void sample(int value);
+
+private:
+  static char classify(int value);
+
+  static int upperBounds[KEYPAD_KEYS];  // Highest reading (exclusive) that maps to each key
+  static char candidateKey;             // Key seen by the latest samples
+  static unsigned long candidateSince;  // When candidateKey was first seen
+  static uint8_t stableSamples;         // Consecutive samples equal to candidateKey
+  static char debouncedKey;             // Key currently held down, after debouncing
+  static volatile uint8_t droppedEvents;
+  static SPSCQueue<KeyEvent, KEYPAD_QUEUE_SIZE> events;
+};
+
+#endif
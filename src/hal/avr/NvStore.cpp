@@ -0,0 +1,12 @@
+#include "hal/NvStore.h"
+#include <EEPROM.h>
+
+NvStore nvStore;
+
+uint8_t NvStore::read(uint16_t address) {
+  return EEPROM.read(address);
+}
+
+void NvStore::write(uint16_t address, uint8_t value) {
+  EEPROM.write(address, value);
+}
@@ -0,0 +1,154 @@
+#include "hal/StackMonitor.h"
+
+#define STACK_GUARD 16 // Bytes below the stack pointer left alone when repainting
+
+extern uint8_t _end;          // End of the static data, from the linker
+extern uint8_t __stack;       // Top of SRAM, from the linker
+extern char __heap_start;
+extern char* __brkval;        // Top of the heap, 0 until malloc() is first used
+
+static PGM_P functionNames[STACK_MAX_FUNCTIONS];
+static uint16_t functionPeaks[STACK_MAX_FUNCTIONS];
+static uint8_t functionCount = 0;
+
+#ifdef STACK_MONITOR
+static uint8_t* openEntrySp[STACK_MAX_DEPTH];   // Stack pointer when each open scope started
+static uint8_t* openDeepest[STACK_MAX_DEPTH];  // Lowest address used during each open scope
+static uint8_t openFunctions[STACK_MAX_DEPTH];
+static uint8_t openCount = 0;
+static uint8_t scopesTooDeep = 0;              // Scopes open beyond STACK_MAX_DEPTH, not tracked
+#endif
+
+static uint16_t minFreeRam = 0xFFFF;
+
+/**
+ * Paint all SRAM above the static data, runs before the C runtime is set up
+ * There is no stack and r1 is not zero yet, so this is written in assembly.
+ */
+extern "C" void paintStack() __attribute__((naked, used, section(".init1")));
+extern "C" void paintStack() {
+  __asm__ __volatile__(
+    "    ldi r30, lo8(_end)\n"
+    "    ldi r31, hi8(_end)\n"
+    "    ldi r24, %[paint]\n"
+    "    ldi r25, hi8(__stack)\n"
+    "    rjmp 2f\n"
+    "1:  st Z+, r24\n"
+    "2:  cpi r30, lo8(__stack)\n"
+    "    cpc r31, r25\n"
+    "    brlo 1b\n"
+    "    breq 1b\n"
+    :: [paint] "M" (STACK_PAINT));
+}
+
+static inline uint8_t* stackPointer() {
+  return (uint8_t*)SP;
+}
+
+static uint8_t* heapTop() {
+  return __brkval != 0 ? (uint8_t*)__brkval : (uint8_t*)&__heap_start;
+}
+
+/**
+ * Find the lowest byte the stack has used since it was last painted
+ * and update the minimum free SRAM
+ */
+static uint8_t* scanDeepest() {
+  uint8_t* p = heapTop();
+  while (p <= &__stack && *p == STACK_PAINT) {
+    p++;
+  }
+  uint16_t freeRam = p - heapTop();
+  if (freeRam < minFreeRam) {
+    minFreeRam = freeRam;
+  }
+  return p;
+}
+
+#ifdef STACK_MONITOR
+/**
+ * Paint the free SRAM below the stack pointer again
+ */
+static void repaint() {
+  uint8_t* top = stackPointer() - STACK_GUARD;
+  for (uint8_t* p = heapTop(); p < top; p++) {
+    *p = STACK_PAINT;
+  }
+}
+
+StackMonitor::Scope::Scope(PGM_P name) {
+  if (openCount == STACK_MAX_DEPTH) {
+    scopesTooDeep++;
+    return;
+  }
+
+  uint8_t function = 0;
+  while (function < functionCount && functionNames[function] != name) {
+    function++;
+  }
+  if (function == functionCount && functionCount < STACK_MAX_FUNCTIONS) {
+    functionNames[functionCount] = name;
+    functionPeaks[functionCount++] = 0;
+  }
+
+  // What the enclosing scope used so far is about to be painted over
+  uint8_t* deepest = scanDeepest();
+  if (openCount > 0 && deepest < openDeepest[openCount - 1]) {
+    openDeepest[openCount - 1] = deepest;
+  }
+  repaint();
+
+  openEntrySp[openCount] = stackPointer();
+  openDeepest[openCount] = openEntrySp[openCount];
+  openFunctions[openCount++] = function;
+}
+
+StackMonitor::Scope::~Scope() {
+  if (scopesTooDeep > 0) {
+    scopesTooDeep--;
+    return;
+  }
+
+  uint8_t* deepest = scanDeepest();
+  uint8_t open = --openCount;
+  if (deepest > openDeepest[open]) {
+    deepest = openDeepest[open];
+  }
+
+  uint8_t function = openFunctions[open];
+  uint16_t peak = openEntrySp[open] - deepest;
+  if (function < functionCount && peak > functionPeaks[function]) {
+    functionPeaks[function] = peak;
+  }
+
+  // The enclosing scope went at least as deep
+  if (open > 0 && deepest < openDeepest[open - 1]) {
+    openDeepest[open - 1] = deepest;
+  }
+}
+#endif
+
+uint16_t StackMonitor::getFreeRam() {
+  return stackPointer() - heapTop();
+}
+
+uint16_t StackMonitor::getMinFreeRam() {
+  scanDeepest();
+  return minFreeRam;
+}
+
+void StackMonitor::printReport(Print& out) {
+  out.print(F("Free SRAM: "));
+  out.print(getFreeRam());
+  out.print(F(" bytes, minimum since boot: "));
+  out.print(getMinFreeRam());
+  out.println(F(" bytes"));
+  out.println(F("Peak stack use:"));
+  for (uint8_t i = 0; i < functionCount; i++) {
+    out.print(F("  "));
+    out.print(reinterpret_cast<const __FlashStringHelper*>(functionNames[i]));
+    out.print(F(": "));
+    out.print(functionPeaks[i]);
+    out.println(F(" bytes"));
+  }
+}
@@ -0,0 +1,26 @@
+#include "hal/Actuator.h"
+#include "NativeHal.h"
+
+static bool energized = false;
+static unsigned long activations = 0;
+
+Actuator solenoid;
+
+void Actuator::begin() {
+  energized = false;
+}
+
+void Actuator::set(bool value) {
+  if (value && !energized) {
+    activations++;
+  }
+  energized = value;
+}
+
+bool Actuator::isEnergized() const {
+  return energized;
+}
+
+unsigned long nativeSolenoidActivations() {
+  return activations;
+}
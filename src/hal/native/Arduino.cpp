@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include "NativeHal.h"
+
+#define SERIAL_INPUT_SIZE 256
+#define SERIAL_OUTPUT_SIZE 4096 // Output kept for nativeSerialOutput(), older bytes are lost
+
+static unsigned long virtualMicros = 0;
+static char serialInput[SERIAL_INPUT_SIZE];
+static size_t serialInputHead = 0;
+static size_t serialInputTail = 0;
+static bool serialEcho = true;
+static uint8_t serialOutput[SERIAL_OUTPUT_SIZE];
+static size_t serialOutputHead = 0;
+static size_t serialOutputTail = 0;
+
+HardwareSerial Serial;
+
+unsigned long millis() {
+  return virtualMicros / 1000;
+}
+
+unsigned long micros() {
+  return virtualMicros;
+}
+
+void delay(unsigned long ms) {
+  nativeAdvanceMicros(ms * 1000);
+}
+
+void nativeAdvanceMicros(unsigned long us) {
+  virtualMicros += us;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(const __FlashStringHelper* text) {
+  return write(reinterpret_cast<const char*>(text));
+}
+
+size_t Print::print(const char* text) {
+  return write(text);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(long value, int base) {
+  if (value < 0 && base == DEC) {
+    return printNumber(-(unsigned long)value, base, true);
+  }
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return write(buffer);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long value, int base, bool negative) {
+  char buffer[8 * sizeof(long) + 2];
+  char* p = buffer + sizeof(buffer) - 1;
+  *p = '\0';
+  do {
+    unsigned digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) {
+    *--p = '-';
+  }
+  return write(p);
+}
+
+int HardwareSerial::available() {
+  return (int)(serialInputHead - serialInputTail);
+}
+
+int HardwareSerial::read() {
+  if (serialInputTail == serialInputHead) {
+    return -1;
+  }
+  return (uint8_t)serialInput[serialInputTail++ % SERIAL_INPUT_SIZE];
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  // Every byte, binary frames such as the audit log dump are sent too
+  if (serialEcho) {
+    putchar(c);
+  }
+  serialOutput[serialOutputHead++ % SERIAL_OUTPUT_SIZE] = c;
+  if (serialOutputHead - serialOutputTail > SERIAL_OUTPUT_SIZE) {
+    serialOutputTail = serialOutputHead - SERIAL_OUTPUT_SIZE;
+  }
+  return 1;
+}
+
+void nativeSerialEcho(bool enabled) {
+  serialEcho = enabled;
+}
+
+void nativeSerialInput(const char* text) {
+  nativeSerialInput((const uint8_t*)text, strlen(text));
+}
+
+void nativeSerialInput(const uint8_t* data, size_t length) {
+  while (length-- > 0 && serialInputHead - serialInputTail < SERIAL_INPUT_SIZE) {
+    serialInput[serialInputHead++ % SERIAL_INPUT_SIZE] = *data++;
+  }
+}
+
+size_t nativeSerialOutput(uint8_t* buffer, size_t size) {
+  size_t count = 0;
+  while (count < size && serialOutputTail != serialOutputHead) {
+    buffer[count++] = serialOutput[serialOutputTail++ % SERIAL_OUTPUT_SIZE];
+  }
+  return count;
+}
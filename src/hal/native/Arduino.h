@@ -0,0 +1,88 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// The part of the Arduino core the firmware uses, for the host build.
+// Time is virtual: it only moves when the simulation advances it.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define DEC 10
+#define HEX 16
+
+// Flash strings are ordinary strings on the host
+class __FlashStringHelper;
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+void setup();
+void loop();
+
+/**
+ * Formatted output, the subset of the Arduino Print class the firmware uses
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+  size_t print(const __FlashStringHelper* text);
+  size_t print(const char* text);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println();
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+  size_t printNumber(unsigned long value, int base, bool negative);
+};
+
+/**
+ * Serial port on stdin/stdout
+ * Output goes to stdout, input is whatever nativeSerialInput() queued.
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  int available();
+  int read();
+  int availableForWrite() { return 63; } // Never busy, output goes straight to stdout
+  void flush() { fflush(stdout); }
+  size_t write(uint8_t c) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
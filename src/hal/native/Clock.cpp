@@ -0,0 +1,33 @@
+#include "hal/Clock.h"
+#include "NativeHal.h"
+
+#define NATIVE_DEFAULT_TIME 1700000000UL // 2023-11-14 22:13:20 UTC
+
+static uint32_t baseTime = NATIVE_DEFAULT_TIME; // Unix time at baseMillis
+static unsigned long baseMillis = 0;
+
+Clock rtcClock;
+
+bool Clock::begin() {
+  return true;
+}
+
+void Clock::update() {
+}
+
+uint32_t Clock::now() {
+  return baseTime + (millis() - baseMillis) / 1000;
+}
+
+void Clock::adjust(uint32_t unixTime) {
+  nativeSetClock(unixTime);
+}
+
+uint32_t Clock::getI2CReadsSavedPerHour() const {
+  return 0;
+}
+
+void nativeSetClock(uint32_t unixTime) {
+  baseTime = unixTime;
+  baseMillis = millis();
+}
@@ -0,0 +1,452 @@
+#include "hal/Display.h"
+#include "NativeHal.h"
+#include "Font5x7.h"
+#include <DigitFont.h>
+
+// Size of a character of the built-in font at text size 1, spacing included
+#define FONT_CELL_WIDTH 6
+#define FONT_CELL_HEIGHT 8
+
+// Bytes of an ST7789 address window: CASET + 4 bytes, RASET + 4 bytes, RAMWR
+#define ADDRESS_WINDOW_BYTES 11
+
+#define MAX_SCOPES 32
+#define MAX_SCOPE_DEPTH 8
+
+static uint16_t frame[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static NativeText texts[NATIVE_MAX_TEXTS];
+static uint8_t textCount = 0;
+static int16_t cursorX = 0;
+static int16_t cursorY = 0;
+static uint8_t textSize = 1;
+static uint16_t textColor = ST77XX_WHITE;
+static NativeText* currentText = nullptr; // Run that printed characters are appended to
+
+static NativeDisplayCost scopes[MAX_SCOPES]; // scopes[0] is everything
+static uint8_t scopeCount = 1;
+static uint8_t openScopes[MAX_SCOPE_DEPTH];
+static uint8_t scopeDepth = 0;
+static uint8_t scopesTooDeep = 0; // Scopes open beyond MAX_SCOPE_DEPTH, not counted
+static unsigned long openScopeBytes[MAX_SCOPE_DEPTH]; // Bytes of each open scope when it was opened
+
+Display display;
+
+/**
+ * Count an address window and the pixels streamed into it,
+ * for the whole display and every open scope
+ */
+static void account(unsigned long pixels) {
+  unsigned long bytes = ADDRESS_WINDOW_BYTES + 2 * pixels;
+  scopes[0].windows++;
+  scopes[0].pixels += pixels;
+  scopes[0].bytes += bytes;
+  for (uint8_t i = 0; i < scopeDepth; i++) {
+    if (openScopes[i] == 0) {
+      continue; // Already counted in the total
+    }
+    NativeDisplayCost& scope = scopes[openScopes[i]];
+    scope.windows++;
+    scope.pixels += pixels;
+    scope.bytes += bytes;
+  }
+}
+
+/**
+ * Fill a rectangle like Adafruit_SPITFT: clipped, one address window
+ */
+static void fill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > DISPLAY_WIDTH) w = DISPLAY_WIDTH - x;
+  if (y + h > DISPLAY_HEIGHT) h = DISPLAY_HEIGHT - y;
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+  for (int16_t row = y; row < y + h; row++) {
+    for (int16_t column = x; column < x + w; column++) {
+      frame[row * DISPLAY_WIDTH + column] = color;
+    }
+  }
+  account((unsigned long)w * h);
+}
+
+/**
+ * Draw a character like Adafruit_GFX::drawChar with a transparent background:
+ * one pixel, or one size x size rectangle, per set pixel of the font
+ */
+static void drawChar(int16_t x, int16_t y, uint8_t c, uint16_t color, uint8_t size) {
+  if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+    return;
+  }
+  for (uint8_t column = 0; column < 5; column++) {
+    uint8_t line = font5x7[c - FONT_FIRST_CHAR][column];
+    for (uint8_t row = 0; row < 8; row++, line >>= 1) {
+      if (line & 1) {
+        fill(x + column * size, y + row * size, size, size, color);
+      }
+    }
+  }
+}
+
+static void removeText(uint8_t index) {
+  memmove(&texts[index], &texts[index + 1], (textCount - index - 1) * sizeof(NativeText));
+  textCount--;
+  currentText = nullptr;
+}
+
+/**
+ * Add a run of text, dropping the oldest run if there is no room
+ */
+static void addText(int16_t x, int16_t y, uint8_t size, uint16_t color, const char* text, uint8_t length) {
+  if (textCount == NATIVE_MAX_TEXTS) {
+    removeText(0);
+  }
+  NativeText& run = texts[textCount++];
+  run = NativeText{x, y, size, color, ""};
+  strncat(run.text, text, length < NATIVE_MAX_TEXT_LENGTH - 1 ? length : NATIVE_MAX_TEXT_LENGTH - 1);
+}
+
+void Display::begin() {
+  textCount = 0;
+  currentText = nullptr;
+}
+
+void Display::fillScreen(uint16_t color) {
+  textCount = 0;
+  currentText = nullptr;
+  fill(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, color);
+}
+
+/**
+ * Remove the runs of text that a rectangle covers any part of
+ */
+static void removeTexts(int16_t x, int16_t y, int16_t w, int16_t h) {
+  for (uint8_t i = textCount; i-- > 0;) {
+    const NativeText& text = texts[i];
+    int16_t textWidth = strlen(text.text) * FONT_CELL_WIDTH * text.size;
+    int16_t textHeight = FONT_CELL_HEIGHT * text.size;
+    if (x < text.x + textWidth && text.x < x + w && y < text.y + textHeight && text.y < y + h) {
+      removeText(i);
+    }
+  }
+}
+
+/**
+ * Fills an address window with the runs of a glyph, row by row
+ */
+struct WindowRuns {
+  uint16_t* pixel; // Next pixel of the window in the frame
+  int16_t w;
+  int16_t column;  // Column of the next pixel in the window
+
+  void writeColor(uint16_t color, uint16_t count) {
+    while (count > 0) {
+      int16_t run = w - column < count ? w - column : count;
+      for (int16_t i = 0; i < run; i++) {
+        pixel[i] = color;
+      }
+      count -= run;
+      column += run;
+      pixel += run;
+      if (column == w) {
+        column = 0;
+        pixel += DISPLAY_WIDTH - w;
+      }
+    }
+  }
+};
+
+void Display::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  removeTexts(x, y, w, h);
+  fill(x, y, w, h, color);
+}
+
+void Display::startWrite() {
+}
+
+void Display::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  fillRect(x, y, w, h, color);
+}
+
+void Display::endWrite() {
+}
+
+void Display::setCursor(int16_t x, int16_t y) {
+  cursorX = x;
+  cursorY = y;
+  currentText = nullptr;
+}
+
+void Display::setTextSize(uint8_t size) {
+  textSize = size;
+  currentText = nullptr;
+}
+
+void Display::setTextColor(uint16_t color) {
+  textColor = color;
+  currentText = nullptr;
+}
+
+size_t Display::write(uint8_t c) {
+  if (c == '\r') {
+    return 1;
+  }
+  if (c == '\n') {
+    cursorX = 0;
+    cursorY += FONT_CELL_HEIGHT * textSize;
+    currentText = nullptr;
+    return 1;
+  }
+
+  // Wrap at the right edge like Adafruit_GFX
+  if (cursorX + FONT_CELL_WIDTH * textSize > DISPLAY_WIDTH) {
+    cursorX = 0;
+    cursorY += FONT_CELL_HEIGHT * textSize;
+    currentText = nullptr;
+  }
+
+  if (currentText == nullptr) {
+    for (uint8_t i = textCount; i-- > 0;) {
+      if (texts[i].x == cursorX && texts[i].y == cursorY) {
+        removeText(i);
+      }
+    }
+    if (textCount == NATIVE_MAX_TEXTS) {
+      removeText(0);
+    }
+    currentText = &texts[textCount++];
+    *currentText = NativeText{cursorX, cursorY, textSize, textColor, ""};
+  }
+
+  size_t length = strlen(currentText->text);
+  if (length < NATIVE_MAX_TEXT_LENGTH - 1) {
+    currentText->text[length] = c;
+    currentText->text[length + 1] = '\0';
+  }
+  drawChar(cursorX, cursorY, c, textColor, textSize);
+  cursorX += FONT_CELL_WIDTH * textSize;
+  return 1;
+}
+
+void Display::drawDigits(int16_t x, int16_t y, const char* text, uint8_t size, uint16_t color, uint16_t background) {
+  int16_t w = DIGIT_FONT_WIDTH * size;
+  int16_t h = DIGIT_FONT_HEIGHT * size;
+  if (x < 0 || y < 0 || y + h > DISPLAY_HEIGHT) {
+    return;
+  }
+  uint8_t count = 0;
+  while (text[count] != '\0' && x + (count + 1) * w <= DISPLAY_WIDTH) {
+    count++;
+  }
+  if (count == 0) {
+    return;
+  }
+
+  // The cells are the size of the built-in font's, so they are recorded as
+  // text of that size and found by nativeDisplayShows() the same way. They
+  // replace the characters under them and join the runs of the same color
+  // they continue, so text redrawn a few characters at a time reads as a
+  // single run, as it does on glass.
+  int16_t right = x + count * w;
+  for (uint8_t i = textCount; i-- > 0;) {
+    NativeText other = texts[i];
+    int16_t otherRight = other.x + strlen(other.text) * FONT_CELL_WIDTH * other.size;
+    int16_t otherBottom = other.y + FONT_CELL_HEIGHT * other.size;
+    if (x >= otherRight || other.x >= right || y >= otherBottom || other.y >= y + h) {
+      continue;
+    }
+    removeText(i);
+    if (other.y != y || other.size != size || (other.x - x) % w != 0) {
+      continue;
+    }
+    // Keep the characters of the run on either side of the cells
+    if (other.x < x) {
+      addText(other.x, y, size, other.color, other.text, (x - other.x) / w);
+    }
+    if (otherRight > right) {
+      addText(right, y, size, other.color, other.text + (right - other.x) / w, (otherRight - right) / w);
+    }
+  }
+
+  char line[2 * NATIVE_MAX_TEXT_LENGTH + DISPLAY_WIDTH / DIGIT_FONT_WIDTH];
+  int16_t left = x;
+  uint8_t length = count;
+  memcpy(line, text, count);
+  for (uint8_t i = textCount; i-- > 0;) {
+    const NativeText& other = texts[i];
+    if (other.y != y || other.size != size || other.color != color) {
+      continue;
+    }
+    uint8_t otherLength = strlen(other.text);
+    if (other.x + otherLength * w == left) {
+      memmove(line + otherLength, line, length);
+      memcpy(line, other.text, otherLength);
+      length += otherLength;
+      left = other.x;
+      removeText(i);
+    } else if (other.x == right) {
+      memcpy(line + length, other.text, otherLength);
+      length += otherLength;
+      removeText(i);
+    }
+  }
+  addText(left, y, size, color, line, length);
+  currentText = nullptr;
+
+  for (uint8_t i = 0; i < count; i++, x += w) {
+    WindowRuns runs = {&frame[y * DISPLAY_WIDTH + x], w, 0};
+    digitFontDraw(runs, digitFontGlyph(text[i]), size, color, background);
+    account((unsigned long)w * h);
+  }
+}
+
+#ifdef TFT_SPI_STATS
+unsigned long Display::getSpiBytes() const {
+  return scopes[0].bytes;
+}
+
+void Display::resetSpiBytes() {
+  scopes[0].bytes = 0;
+}
+#endif
+
+DisplayScope::DisplayScope(const char* name) {
+  uint8_t index = 1;
+  while (index < scopeCount && strcmp(scopes[index].name, name) != 0) {
+    index++;
+  }
+  if (index == scopeCount) {
+    if (scopeCount == MAX_SCOPES) {
+      index = 0; // Out of room, only counted in the total
+    } else {
+      scopes[scopeCount++] = NativeDisplayCost{name, 0, 0, 0, 0, 0};
+    }
+  }
+
+  if (scopeDepth == MAX_SCOPE_DEPTH) {
+    scopesTooDeep++;
+    return;
+  }
+  if (index != 0) {
+    scopes[index].calls++;
+  }
+  openScopeBytes[scopeDepth] = scopes[index].bytes;
+  openScopes[scopeDepth++] = index;
+}
+
+DisplayScope::~DisplayScope() {
+  // Scopes are objects with automatic storage, so they close in reverse order
+  if (scopesTooDeep > 0) {
+    scopesTooDeep--;
+  } else if (scopeDepth > 0) {
+    scopeDepth--;
+    NativeDisplayCost& scope = scopes[openScopes[scopeDepth]];
+    unsigned long bytes = scope.bytes - openScopeBytes[scopeDepth];
+    if (bytes > scope.maxBytes) {
+      scope.maxBytes = bytes;
+    }
+  }
+}
+
+const NativeText* nativeDisplayTexts(uint8_t& count) {
+  count = textCount;
+  return texts;
+}
+
+bool nativeDisplayShows(const char* text) {
+  for (uint8_t i = 0; i < textCount; i++) {
+    if (strstr(texts[i].text, text) != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void nativeDisplayDump(FILE* out) {
+  for (uint8_t i = 0; i < textCount; i++) {
+    fprintf(out, "(%3d,%3d) x%u #%04X %s\n", texts[i].x, texts[i].y, texts[i].size, texts[i].color, texts[i].text);
+  }
+}
+
+const uint16_t* nativeDisplayFrame() {
+  return frame;
+}
+
+const NativeDisplayCost* nativeDisplayCost(const char* name) {
+  if (name == nullptr) {
+    return &scopes[0];
+  }
+  for (uint8_t i = 1; i < scopeCount; i++) {
+    if (strcmp(scopes[i].name, name) == 0) {
+      return &scopes[i];
+    }
+  }
+  return nullptr;
+}
+
+void nativeDisplayResetCosts() {
+  for (uint8_t i = 0; i < scopeCount; i++) {
+    scopes[i] = NativeDisplayCost{scopes[i].name, 0, 0, 0, 0, 0};
+  }
+  // Restart the open scopes at zero
+  for (uint8_t i = 0; i < scopeDepth; i++) {
+    openScopeBytes[i] = 0;
+  }
+}
+
+void nativeDisplayReport(FILE* out) {
+  fprintf(out, "%-26s %8s %9s %11s %12s %10s\n", "scope", "calls", "windows", "pixels", "bytes", "max/call");
+  for (uint8_t i = 1; i < scopeCount; i++) {
+    const NativeDisplayCost& scope = scopes[i];
+    fprintf(out, "%-26s %8lu %9lu %11lu %12lu %10lu\n", scope.name, scope.calls, scope.windows, scope.pixels,
+            scope.bytes, scope.maxBytes);
+  }
+  fprintf(out, "%-26s %8s %9lu %11lu %12lu\n", "total", "", scopes[0].windows, scopes[0].pixels, scopes[0].bytes);
+}
+
+bool nativeDisplaySavePpm(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  for (uint32_t i = 0; i < (uint32_t)DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+    uint16_t color = frame[i];
+    // Expand RGB565 to 8 bits per channel, replicating the top bits
+    uint8_t rgb[3] = {
+      (uint8_t)((color >> 8 & 0xF8) | (color >> 13)),
+      (uint8_t)((color >> 3 & 0xFC) | (color >> 9 & 0x03)),
+      (uint8_t)((color << 3 & 0xF8) | (color >> 2 & 0x07))
+    };
+    fwrite(rgb, 1, sizeof(rgb), file);
+  }
+  return fclose(file) == 0;
+}
+
+long nativeDisplayComparePpm(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return -1;
+  }
+  int width = 0, height = 0, maxValue = 0;
+  if (fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) != 3 || width != DISPLAY_WIDTH ||
+      height != DISPLAY_HEIGHT || maxValue != 255 || fgetc(file) == EOF) {
+    fclose(file);
+    return -1;
+  }
+
+  long differences = 0;
+  for (uint32_t i = 0; i < (uint32_t)DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+    uint8_t rgb[3];
+    if (fread(rgb, 1, sizeof(rgb), file) != sizeof(rgb)) {
+      fclose(file);
+      return -1;
+    }
+    uint16_t color = (rgb[0] & 0xF8) << 8 | (rgb[1] & 0xFC) << 3 | rgb[2] >> 3;
+    if (color != frame[i]) {
+      differences++;
+    }
+  }
+  fclose(file);
+  return differences;
+}
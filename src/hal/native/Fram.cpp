@@ -0,0 +1,37 @@
+#include "hal/Fram.h"
+#include "NativeHal.h"
+
+// Starts out as zeros, like a new part
+static uint8_t memory[FRAM_SIZE];
+static unsigned long writes = 0;
+
+Fram fram;
+
+bool Fram::begin() {
+  return true;
+}
+
+bool Fram::read(uint16_t address, uint8_t* data, uint8_t length) {
+  if ((uint32_t)address + length > FRAM_SIZE) {
+    return false;
+  }
+  memcpy(data, memory + address, length);
+  return true;
+}
+
+bool Fram::write(uint16_t address, const uint8_t* data, uint8_t length) {
+  if ((uint32_t)address + length > FRAM_SIZE) {
+    return false;
+  }
+  memcpy(memory + address, data, length);
+  writes++;
+  return true;
+}
+
+uint8_t* nativeFramData() {
+  return memory;
+}
+
+unsigned long nativeFramWrites() {
+  return writes;
+}
@@ -0,0 +1,29 @@
+#include "hal/Keypad.h"
+#include "NativeHal.h"
+#include <SPSCQueue.h>
+
+#define NATIVE_KEYPAD_QUEUE_SIZE 8 // Same depth as the queue on the board
+
+static SPSCQueue<KeyEvent, NATIVE_KEYPAD_QUEUE_SIZE> events;
+static uint8_t droppedEvents = 0;
+
+Keypad keypad;
+
+void Keypad::begin() {
+}
+
+bool Keypad::readEvent(KeyEvent& event) {
+  return events.pop(event);
+}
+
+uint8_t Keypad::getDroppedEvents() const {
+  return droppedEvents;
+}
+
+bool nativePressKey(char key) {
+  if (!events.push(KeyEvent{key, millis()})) {
+    droppedEvents++;
+    return false;
+  }
+  return true;
+}
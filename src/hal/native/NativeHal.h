@@ -0,0 +1,137 @@
+#ifndef NATIVE_HAL_H
+#define NATIVE_HAL_H
+
+#include <Arduino.h>
+
+// Hooks for driving the host build of the firmware, the firmware itself
+// only sees the interfaces in include/hal
+
+/**
+ * Advance the virtual time seen by millis() and micros()
+ */
+void nativeAdvanceMicros(unsigned long us);
+
+/**
+ * Queue characters to be read from Serial
+ */
+void nativeSerialInput(const char* text);
+void nativeSerialInput(const uint8_t* data, size_t length);
+
+/**
+ * Take the bytes the firmware wrote to Serial since the last call
+ * Only the last few kilobytes are kept.
+ * @return The number of bytes copied to the buffer
+ */
+size_t nativeSerialOutput(uint8_t* buffer, size_t size);
+
+/**
+ * Choose whether Serial output is copied to stdout (the default)
+ */
+void nativeSerialEcho(bool enabled);
+
+/**
+ * Set the wall clock time, as if the RTC had been set
+ * @param unixTime The unix time in seconds at the current millis()
+ */
+void nativeSetClock(uint32_t unixTime);
+
+/**
+ * Queue a key press, timestamped with the current millis()
+ * @return false if the keypad queue is full
+ */
+bool nativePressKey(char key);
+
+/**
+ * Access the nonvolatile store contents, NV_STORE_SIZE bytes
+ */
+uint8_t* nativeNvStoreData();
+unsigned long nativeNvStoreWrites();
+
+/**
+ * Access the FRAM contents, FRAM_SIZE bytes, and count its write transactions
+ */
+uint8_t* nativeFramData();
+unsigned long nativeFramWrites();
+
+/**
+ * Get the number of times the solenoid was energized
+ */
+unsigned long nativeSolenoidActivations();
+
+#define NATIVE_MAX_TEXTS 32
+#define NATIVE_MAX_TEXT_LENGTH 32
+
+/**
+ * A run of text on the fake display
+ */
+struct NativeText {
+  int16_t x;
+  int16_t y;
+  uint8_t size;
+  uint16_t color;
+  char text[NATIVE_MAX_TEXT_LENGTH];
+};
+
+/**
+ * Get the text on the fake display
+ * A run is removed when a rectangle is filled over any part of it or
+ * new text starts at the same position.
+ * @param count Receives the number of runs
+ * @return The runs, in the order they were drawn
+ */
+const NativeText* nativeDisplayTexts(uint8_t& count);
+
+/**
+ * Check whether some text on the fake display contains a string
+ */
+bool nativeDisplayShows(const char* text);
+
+/**
+ * Print the text on the fake display, one run per line
+ */
+void nativeDisplayDump(FILE* out);
+
+/**
+ * Get the framebuffer of the fake display, DISPLAY_WIDTH x DISPLAY_HEIGHT RGB565 pixels
+ */
+const uint16_t* nativeDisplayFrame();
+
+/**
+ * Save the framebuffer as a binary PPM image
+ * @return false if the file could not be written
+ */
+bool nativeDisplaySavePpm(const char* path);
+
+/**
+ * Compare the framebuffer with a PPM image saved by nativeDisplaySavePpm()
+ * @return The number of pixels that differ, -1 if the image could not be read
+ */
+long nativeDisplayComparePpm(const char* path);
+
+/**
+ * Display traffic counted under a DISPLAY_SCOPE(), as the ST7789 would receive it
+ */
+struct NativeDisplayCost {
+  const char* name;
+  unsigned long calls;    // Times the scope was entered
+  unsigned long windows;  // Address windows opened (one per rectangle or pixel drawn)
+  unsigned long pixels;   // Pixels streamed into them
+  unsigned long bytes;    // Bytes over SPI, ADDRESS_WINDOW_BYTES per window and 2 per pixel
+  unsigned long maxBytes; // Most bytes of a single call
+};
+
+/**
+ * Get the traffic of a scope
+ * @param name The scope, the function name for DISPLAY_SCOPE(), or nullptr for all traffic
+ * @return The counts, nullptr if the scope was never entered
+ */
+const NativeDisplayCost* nativeDisplayCost(const char* name);
+
+void nativeDisplayResetCosts();
+
+/**
+ * Print the traffic of every scope
+ */
+void nativeDisplayReport(FILE* out);
+
+#endif
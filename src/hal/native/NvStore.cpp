@@ -0,0 +1,30 @@
+#include "hal/NvStore.h"
+#include "NativeHal.h"
+
+// Starts out erased, like a new chip
+static struct ErasedStore {
+  ErasedStore() { memset(bytes, 0xFF, sizeof(bytes)); }
+  uint8_t bytes[NV_STORE_SIZE];
+} store;
+static unsigned long writes = 0;
+
+NvStore nvStore;
+
+uint8_t NvStore::read(uint16_t address) {
+  return address < NV_STORE_SIZE ? store.bytes[address] : 0xFF;
+}
+
+void NvStore::write(uint16_t address, uint8_t value) {
+  if (address < NV_STORE_SIZE) {
+    store.bytes[address] = value;
+    writes++;
+  }
+}
+
+uint8_t* nativeNvStoreData() {
+  return store.bytes;
+}
+
+unsigned long nativeNvStoreWrites() {
+  return writes;
+}
@@ -0,0 +1,441 @@
+#include <Arduino.h>
+#include <TotpEngine.h>
+#include <TotpCodeCache.h>
+#include <AuditLog.h>
+#include <Frame.h>
+#include <FrameParser.h>
+#include <FrameTypes.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "NativeHal.h"
+#include "hal/Actuator.h"
+#include "hal/Clock.h"
+#include "hal/NvStore.h"
+
+// Device simulator: runs setup() and loop() against the fakes in this
+// directory in virtual time, replaying a scenario script. Waiting only costs
+// loop() passes, one per tick of virtual time, so hours of door traffic run
+// in seconds.
+//
+// Usage: program [-v] scenario
+//   -v  print the commands as they run and the firmware's Serial output
+//
+// Scenario commands, one per line, # starts a comment:
+//   clock <unixTime>        set the RTC (before boot: the time at boot)
+//   skew <seconds>          move the RTC away from the true time the phones use
+//   tick <duration>         virtual time per pass of loop() (default 10ms)
+//   eeprom <file>           load an Intel HEX EEPROM image, such as tools/provision writes
+//   boot                    run setup()
+//   wait <duration>         run loop() for a while, e.g. 500ms, 3s, 25m, 2h, 1d
+//   key <keys>              press keys, KEY_INTERVAL apart
+//   totp [user] [offset]    type the code a user's phone shows, offset in time steps
+//   serial <text>           send text over Serial
+//   frame <type> [payload]  send a command frame, type and payload in hex, e.g. frame 02 04
+//   expect solenoid on|off
+//   expect activations <n> total number of unlocks
+//   expect audit <n>        records in the audit log
+//   expect reply <type> <s> the last frame command was answered with status s
+//   expect screen <text>    some text on screen contains <text>
+//   expect !screen <text>   no text on screen contains <text>
+//   expect image <file>     the screen matches a PPM snapshot pixel for pixel
+//   expect cost <scope> <n> no call of a DISPLAY_SCOPE() sent more than n bytes to the display
+//   dump                    print the text on screen
+//   snapshot <file>         save the screen as a PPM image
+//   report                  print the display traffic of every DISPLAY_SCOPE()
+//   repeat <n> ... end      run the enclosed commands n times
+
+#define DEFAULT_TICK_MICROS 10000UL
+#define KEY_INTERVAL 150 // Milliseconds between two key presses
+
+uint8_t readUserKey(uint8_t user, uint8_t* key); // From main.cpp
+extern AuditLog auditLog;
+
+struct Line {
+  int number;
+  std::string command;
+  std::string argument;
+};
+
+static std::vector<Line> script;
+static unsigned long tickMicros = DEFAULT_TICK_MICROS;
+static long skewSeconds = 0; // RTC time minus true time
+static bool booted = false;
+static bool verbose = false;
+static unsigned long expectations = 0;
+static uint8_t frameSent = 0; // Type of the last command frame sent
+static FrameParser replyParser;
+
+static void fail(const Line& line, const char* message) {
+  fflush(stdout);
+  fprintf(stderr, "line %d: %s %s: %s\n", line.number, line.command.c_str(), line.argument.c_str(), message);
+  if (booted) {
+    fprintf(stderr, "screen at %lu ms:\n", millis());
+    nativeDisplayDump(stderr);
+  }
+  exit(1);
+}
+
+/**
+ * Parse a duration such as 500ms, 3s, 25m, 2h or 1d
+ * @return The duration in microseconds, 0 if it is not valid
+ */
+static unsigned long long parseDuration(const std::string& text) {
+  char* unit;
+  unsigned long long value = strtoull(text.c_str(), &unit, 10);
+  if (strcmp(unit, "ms") == 0) return value * 1000ULL;
+  if (strcmp(unit, "s") == 0) return value * 1000000ULL;
+  if (strcmp(unit, "m") == 0) return value * 60000000ULL;
+  if (strcmp(unit, "h") == 0) return value * 3600000000ULL;
+  if (strcmp(unit, "d") == 0) return value * 86400000000ULL;
+  return 0;
+}
+
+static void boot() {
+  if (!booted) {
+    booted = true;
+    setup();
+  }
+}
+
+static void run(unsigned long long micros) {
+  boot();
+  for (unsigned long long elapsed = 0; elapsed < micros; elapsed += tickMicros) {
+    loop();
+    nativeAdvanceMicros(tickMicros);
+  }
+}
+
+static void pressKeys(const Line& line, const char* keys) {
+  boot();
+  for (; *keys; keys++) {
+    if (!nativePressKey(*keys)) {
+      fail(line, "keypad queue full");
+    }
+    run(KEY_INTERVAL * 1000ULL);
+  }
+}
+
+/**
+ * Type the code a user's authenticator app shows
+ */
+static void typeTotp(const Line& line) {
+  int user = 0, offset = 0;
+  sscanf(line.argument.c_str(), "%d %d", &user, &offset);
+
+  uint8_t key[TOTP_MAX_KEY_LENGTH];
+  uint8_t keyLength = readUserKey(user, key);
+  if (keyLength == 0) {
+    fail(line, "no such user");
+  }
+  TotpEngine engine;
+  engine.begin(key, keyLength);
+
+  uint32_t trueTime = rtcClock.now() - skewSeconds;
+  char code[TOTP_DIGITS + 1];
+  TotpEngine::formatCode(engine.getCodeFromSteps(trueTime / TOTP_TIME_STEP + offset), code);
+  pressKeys(line, code);
+}
+
+/**
+ * Load an Intel HEX image into the nonvolatile store
+ * @return false if the file cannot be read or is not Intel HEX
+ */
+static bool loadEeprom(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t* store = nativeNvStoreData();
+  char buffer[600];
+  bool valid = true;
+  while (valid && fgets(buffer, sizeof(buffer), file)) {
+    unsigned length, address, type;
+    if (sscanf(buffer, ":%2x%4x%2x", &length, &address, &type) != 3) {
+      valid = false;
+    } else if (type == 0) {
+      for (unsigned i = 0; i < length && valid; i++) {
+        unsigned value;
+        valid = sscanf(buffer + 9 + 2 * i, "%2x", &value) == 1 && address + i < NV_STORE_SIZE;
+        if (valid) {
+          store[address + i] = value;
+        }
+      }
+    }
+  }
+  fclose(file);
+  return valid;
+}
+
+/**
+ * Parse hex digits into bytes, spaces are ignored
+ * @return The number of bytes, -1 if the text is not hex
+ */
+static int parseHex(const std::string& text, uint8_t* bytes, int size) {
+  int count = 0;
+  for (size_t i = 0; i < text.size();) {
+    if (text[i] == ' ') {
+      i++;
+      continue;
+    }
+    unsigned value;
+    if (count == size || i + 1 >= text.size() || sscanf(text.c_str() + i, "%2x", &value) != 1) {
+      return -1;
+    }
+    bytes[count++] = value;
+    i += 2;
+  }
+  return count;
+}
+
+/**
+ * Send a command frame
+ */
+static void sendFrame(const Line& line) {
+  uint8_t bytes[1 + FRAME_PARSER_SIZE];
+  int count = parseHex(line.argument, bytes, sizeof(bytes));
+  if (count < 1) {
+    fail(line, "expected a type and payload in hex");
+  }
+  boot();
+
+  // Replies to earlier commands do not count
+  uint8_t output[256];
+  while (nativeSerialOutput(output, sizeof(output)) > 0) {
+  }
+  replyParser.reset();
+
+  struct Input {
+    void write(uint8_t value) { nativeSerialInput(&value, 1); }
+  } input;
+  writeFrame(input, bytes[0], bytes + 1, count - 1);
+  frameSent = bytes[0];
+}
+
+/**
+ * Find the reply to the last command frame in the Serial output
+ * @return The status, -1 if there is no reply
+ */
+static int findReply() {
+  uint8_t output[256];
+  size_t count;
+  while ((count = nativeSerialOutput(output, sizeof(output))) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      if (replyParser.feed(output[i]) && replyParser.getType() == (frameSent | FRAME_REPLY) &&
+          replyParser.getLength() > 0) {
+        return replyParser.getPayload()[0];
+      }
+    }
+  }
+  return -1;
+}
+
+static void expect(const Line& line) {
+  expectations++;
+  const std::string& argument = line.argument;
+  size_t space = argument.find(' ');
+  std::string what = argument.substr(0, space);
+  std::string value = space == std::string::npos ? "" : argument.substr(space + 1);
+
+  if (what == "solenoid") {
+    if (value != "on" && value != "off") {
+      fail(line, "expected on or off");
+    }
+    if (solenoid.isEnergized() != (value == "on")) {
+      fail(line, solenoid.isEnergized() ? "solenoid is on" : "solenoid is off");
+    }
+  } else if (what == "activations") {
+    if (nativeSolenoidActivations() != strtoul(value.c_str(), nullptr, 10)) {
+      char message[48];
+      snprintf(message, sizeof(message), "%lu activations", nativeSolenoidActivations());
+      fail(line, message);
+    }
+  } else if (what == "audit") {
+    if (auditLog.getCount() != strtoul(value.c_str(), nullptr, 10)) {
+      char message[48];
+      snprintf(message, sizeof(message), "%u records", auditLog.getCount());
+      fail(line, message);
+    }
+  } else if (what == "reply") {
+    unsigned type, status;
+    if (sscanf(value.c_str(), "%x %u", &type, &status) != 2) {
+      fail(line, "expected a type in hex and a status");
+    }
+    if (type != frameSent) {
+      fail(line, "not the last frame sent");
+    }
+    int reply = findReply();
+    if (reply != (int)status) {
+      char message[48];
+      snprintf(message, sizeof(message), reply < 0 ? "no reply" : "status %d", reply);
+      fail(line, message);
+    }
+  } else if (what == "screen") {
+    if (!nativeDisplayShows(value.c_str())) {
+      fail(line, "not on screen");
+    }
+  } else if (what == "!screen") {
+    if (nativeDisplayShows(value.c_str())) {
+      fail(line, "on screen");
+    }
+  } else if (what == "image") {
+    long differences = nativeDisplayComparePpm(value.c_str());
+    if (differences != 0) {
+      char message[48];
+      snprintf(message, sizeof(message), differences < 0 ? "cannot read image" : "%ld pixels differ", differences);
+      fail(line, message);
+    }
+  } else if (what == "cost") {
+    char scope[64];
+    unsigned long limit;
+    if (sscanf(value.c_str(), "%63s %lu", scope, &limit) != 2) {
+      fail(line, "expected a scope and a byte count");
+    }
+    const NativeDisplayCost* cost = nativeDisplayCost(scope);
+    if (cost == nullptr) {
+      fail(line, "scope never entered");
+    }
+    if (cost->maxBytes > limit) {
+      char message[48];
+      snprintf(message, sizeof(message), "%lu bytes in one call", cost->maxBytes);
+      fail(line, message);
+    }
+  } else {
+    fail(line, "unknown expectation");
+  }
+}
+
+/**
+ * Find the end matching the repeat at a line
+ */
+static size_t findEnd(size_t start) {
+  int depth = 0;
+  for (size_t i = start; i < script.size(); i++) {
+    if (script[i].command == "repeat") {
+      depth++;
+    } else if (script[i].command == "end" && --depth == 0) {
+      return i;
+    }
+  }
+  fail(script[start], "no matching end");
+  return 0;
+}
+
+static void execute(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    const Line& line = script[i];
+    const std::string& command = line.command;
+    if (verbose) {
+      printf("[%lu ms] %s %s\n", millis(), command.c_str(), line.argument.c_str());
+    }
+
+    if (command == "repeat") {
+      size_t blockEnd = findEnd(i);
+      unsigned long count = strtoul(line.argument.c_str(), nullptr, 10);
+      for (unsigned long n = 0; n < count; n++) {
+        execute(i + 1, blockEnd);
+      }
+      i = blockEnd;
+    } else if (command == "clock") {
+      nativeSetClock(strtoul(line.argument.c_str(), nullptr, 10) + skewSeconds);
+    } else if (command == "skew") {
+      long seconds = strtol(line.argument.c_str(), nullptr, 10);
+      nativeSetClock(rtcClock.now() + seconds - skewSeconds);
+      skewSeconds = seconds;
+    } else if (command == "tick") {
+      tickMicros = parseDuration(line.argument);
+      if (tickMicros == 0) {
+        fail(line, "bad duration");
+      }
+    } else if (command == "eeprom") {
+      if (booted) {
+        fail(line, "only before boot");
+      }
+      if (!loadEeprom(line.argument.c_str())) {
+        fail(line, "cannot load image");
+      }
+    } else if (command == "boot") {
+      boot();
+    } else if (command == "wait") {
+      unsigned long long duration = parseDuration(line.argument);
+      if (duration == 0) {
+        fail(line, "bad duration");
+      }
+      run(duration);
+    } else if (command == "key") {
+      pressKeys(line, line.argument.c_str());
+    } else if (command == "totp") {
+      typeTotp(line);
+    } else if (command == "serial") {
+      boot();
+      nativeSerialInput(line.argument.c_str());
+    } else if (command == "frame") {
+      sendFrame(line);
+    } else if (command == "expect") {
+      expect(line);
+    } else if (command == "dump") {
+      nativeDisplayDump(stdout);
+    } else if (command == "snapshot") {
+      if (!nativeDisplaySavePpm(line.argument.c_str())) {
+        fail(line, "cannot write image");
+      }
+    } else if (command == "report") {
+      nativeDisplayReport(stdout);
+    } else {
+      fail(line, "unknown command");
+    }
+  }
+}
+
+static void load(FILE* file) {
+  char buffer[256];
+  for (int number = 1; fgets(buffer, sizeof(buffer), file); number++) {
+    std::string text(buffer);
+    text = text.substr(0, text.find('#'));
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+      continue;
+    }
+    text = text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+
+    size_t space = text.find(' ');
+    Line line{number, text.substr(0, space), ""};
+    if (space != std::string::npos) {
+      line.argument = text.substr(text.find_first_not_of(' ', space));
+    }
+    script.push_back(line);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (path == nullptr) {
+    fprintf(stderr, "Usage: %s [-v] scenario\n", argv[0]);
+    return 2;
+  }
+
+  nativeSerialEcho(verbose);
+
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    perror(path);
+    return 2;
+  }
+  load(file);
+  fclose(file);
+
+  clock_t start = clock();
+  execute(0, script.size());
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf("PASS %s: %lu expectations, %lu activations, %.1f h simulated in %.2f s\n", path, expectations,
+         nativeSolenoidActivations(), millis() / 3600000.0, seconds);
+  return 0;
+}
@@ -0,0 +1,13 @@
+#include "hal/StackMonitor.h"
+
+uint16_t StackMonitor::getFreeRam() {
+  return 0;
+}
+
+uint16_t StackMonitor::getMinFreeRam() {
+  return 0;
+}
+
+void StackMonitor::printReport(Print& out) {
+  out.println(F("Stack monitoring is only available on the board"));
+}
@@ -1,54 +1,157 @@
-#include <qrcode.h>
 #include <Arduino.h>
-#include "RTClib.h"
-#include "sha1.h"
-#include "TOTP.h"
-#include <Adafruit_GFX.h>
-#include <Adafruit_ST7789.h>
-#include <SPI.h>
-#include <OnePinKeypad.h>
-#include <EEPROM.h>
-
-// Define ST7789 display pin connection
-#define TFT_CS     10   
-#define TFT_RST     8    
-#define TFT_DC      9
+#include <Base32.h>
+#include <Otpauth.h>
+#include <TextFormat.h>
+#include <DigitFont.h>
+#include <ScreenCompositor.h>
+#include <StaticQRCode.h>
+#include <TotpEngine.h>
+#include <TotpCodeCache.h>
+#include <TotpVerifier.h>
+#include <ConfigStore.h>
+#include <AuditLog.h>
+#include <Frame.h>
+#include <FrameParser.h>
+#include <FrameTypes.h>
+#include "hal/Actuator.h"
+#include "hal/Clock.h"
+#include "hal/Display.h"
+#include "hal/Fram.h"
+#include "hal/Keypad.h"
+#include "hal/NvStore.h"
+#include "hal/StackMonitor.h"
+#include "EepromLayout.h"
+
 #define ST77XX_GREY 0x7BEF
 
-// Define Analog Pin for keypad
-#define KEYPAD_PIN A0
-#define NO_KEY '\0'
+#define DRIFT_SAVE_THRESHOLD 2    // Change in the drift estimate worth an EEPROM write
+
+static_assert(NV_STORE_SIZE >= EEPROM_LAYOUT_SIZE, "The EEPROM layout does not fit in the nonvolatile store");
+static_assert(TOTP_MAX_USERS == EEPROM_USER_COUNT + 1,
+              "The code index must hold user 0 and every user of the EEPROM table, set TOTP_MAX_USERS in platformio.ini");
 
-#define SOLENOID_PIN 3 // Pin for the solenoid lock
+// Audit log of access attempts, the whole FRAM holds 4095 records
+#define AUDIT_LOG_ADDR 0
+#define AUDIT_LOG_SIZE FRAM_SIZE
 
-// EEPROM Storage definitions for storing timezone offset
-#define EEPROM_MAGIC_MARKER "TOTP"  // 4-byte marker to verify EEPROM has been initialized
-#define EEPROM_MAGIC_ADDR 0         // Starting address for magic marker
-#define EEPROM_TZ_ADDR 4  
+#define COMMAND_TIMEOUT 250 // Milliseconds of silence that drop a partly received command frame
 
-Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+// Code entry cell layout (digit font size 4 draws each character in a 24x28 cell)
+#define CODE_CELL_X 45       // X coordinate of the first code cell
+#define CODE_CELL_Y 120      // Y coordinate of the code cells
+#define CODE_CELL_WIDTH 24   // Horizontal pitch between code cells
+#define CODE_TEXT_SIZE 4     // Digit font scale of the code cells
 
-// Create a keypad object
-OnePinKeypad keypad(KEYPAD_PIN);
+// Clock layout (digit font size 2 draws each character in a 12x14 cell)
+#define CLOCK_CELLS 10       // Cells of the clock, enough for 12:59:59PM
+#define CLOCK_Y 10           // Y coordinate of the clock cells
+#define CLOCK_TEXT_SIZE 2    // Digit font scale of the clock
+#define CLOCK_CELL_WIDTH (DIGIT_FONT_WIDTH * CLOCK_TEXT_SIZE)
+#define CLOCK_WIDTH (CLOCK_CELLS * CLOCK_CELL_WIDTH)
+#define CLOCK_HEIGHT (DIGIT_FONT_HEIGHT * CLOCK_TEXT_SIZE)
+#define CLOCK_X ((DISPLAY_WIDTH - CLOCK_WIDTH) / 2)
 
-// Calibrated thresholds for the keypad
-int myThresholds[16] = {6, 84, 152, 207, 252, 297, 337, 373, 400, 430, 457, 482, 501, 522, 542, 560};
+// Countdown bar of the current TOTP time step, between the code cells and the instructions
+#define COUNTDOWN_X 30          // X coordinate of the full bar
+#define COUNTDOWN_Y 158         // Y coordinate of the bar
+#define COUNTDOWN_WIDTH 180     // Width of the full bar, 6 pixels per second of a time step
+#define COUNTDOWN_HEIGHT 6      // Height of the bar
+#define COUNTDOWN_WARNING 5     // Seconds left when the bar turns red
+static_assert(COUNTDOWN_WIDTH % TOTP_TIME_STEP == 0, "The countdown bar should shrink by whole pixels");
 
-RTC_DS3231 rtc;
+// Timezone setup layout (text size 3 draws each character in an 18x24 cell)
+#define TIMEZONE_Y 100       // Y coordinate of the offset
+#define TIMEZONE_TEXT_SIZE 3 // Text size of the offset
+#define TIMEZONE_MAX_WIDTH (8 * SCREEN_CHAR_WIDTH * TIMEZONE_TEXT_SIZE) // Width of the longest offset, UTC-12.5
+#define TIMEZONE_X ((DISPLAY_WIDTH - TIMEZONE_MAX_WIDTH) / 2)
+#define TIMEZONE_HEIGHT (SCREEN_CHAR_HEIGHT * TIMEZONE_TEXT_SIZE)
+
+// The hardware (display, rtcClock, keypad, nvStore and solenoid) is reached
+// through the interfaces in include/hal, implemented in src/hal/avr for the
+// board and src/hal/native for the host build
 
 // The shared secret is shTGPxibDo (feel free to change it using https://www.lucadentella.it/OTP/)
-uint8_t hmacKey[] = {0x73, 0x68, 0x54, 0x47, 0x50, 0x78, 0x69, 0x62, 0x44, 0x6f, 0x63, 0x33, 0x51, 0x39, 0x54, 0x36};
+constexpr uint8_t hmacKey[] = {0x73, 0x68, 0x54, 0x47, 0x50, 0x78, 0x69, 0x62, 0x44, 0x6f, 0x63, 0x33, 0x51, 0x39, 0x54, 0x36};
+constexpr int hmacKeyLength = 10; // Number of bytes of hmacKey used as the secret
+
+uint8_t readUserKey(uint8_t user, uint8_t* key);
+TotpCodeCache totpCache(readUserKey); // Every user's code for the time steps in the verification window
+unsigned long indexBuildMicros = 0; // Time spent building the code index since boot
+TotpVerifier totpVerifier(totpCache); // Accepts codes within TOTP_WINDOW steps, learns the drift
+int8_t savedDrift = 0; // Drift estimate last written to EEPROM
+
+uint8_t readNvStore(uint16_t address);
+void writeNvStore(uint16_t address, uint8_t value);
+ConfigStore settingsStore(SETTINGS_ADDR, SETTINGS_REGION_SIZE, sizeof(Settings), readNvStore, writeNvStore);
+Settings settings; // The settings as last saved
+
+bool readFram(uint16_t address, uint8_t* data, uint8_t length);
+bool writeFram(uint16_t address, const uint8_t* data, uint8_t length);
+AuditLog auditLog(AUDIT_LOG_ADDR, AUDIT_LOG_SIZE, readFram, writeFram); // Every verification, kept in FRAM
+bool logDumping = false; // Whether the audit log is being sent over Serial
+uint16_t logDumpIndex = 0; // Next record of the audit log to send
+
+FrameParser commandParser; // Command frames received over Serial
+unsigned long lastSerialByteTime = 0; // When the last byte of a command frame arrived
+
+// QR code of the TOTP URI for Google Authenticator, encoded by the compiler and stored in flash
+#define TOTP_QR_VERSION 4 // QR code version (1-10, higher means bigger size)
+constexpr OtpauthUri totpUri = makeOtpauthUri(hmacKey, hmacKeyLength, "Door:Lock", "TOTPLock");
+static_assert(totpUri.length > 0, "The TOTP URI does not fit in OTPAUTH_URI_MAX_LENGTH");
+constexpr QRBitmap<TOTP_QR_VERSION> totpQRCode PROGMEM = qrEncodeText<TOTP_QR_VERSION>(totpUri.text, QR_ECC_LOW);
+static_assert(totpQRCode.valid, "The TOTP URI does not fit in a QR code of version TOTP_QR_VERSION");
 
-TOTP totp = TOTP(hmacKey, 10);
+// The screens, as tables of what they show in flash. The background
+// colored rectangles are the areas that the firmware draws into.
+constexpr ScreenElement defaultScreen[] PROGMEM = {
+  screenRect(CLOCK_X, CLOCK_Y, CLOCK_WIDTH, CLOCK_HEIGHT, ST77XX_BLACK),
+  screenText(DISPLAY_WIDTH / 2, 50, 2, ST77XX_WHITE, "Enter Code:"),
+  screenRect(CODE_CELL_X, CODE_CELL_Y, 6 * CODE_CELL_WIDTH, DIGIT_FONT_HEIGHT * CODE_TEXT_SIZE, ST77XX_BLACK),
+  screenRect(COUNTDOWN_X, COUNTDOWN_Y, COUNTDOWN_WIDTH, COUNTDOWN_HEIGHT, ST77XX_BLACK),
+  screenText(DISPLAY_WIDTH / 2, 180, 2, ST77XX_GREEN, "Press * to clear"),
+  screenText(DISPLAY_WIDTH / 2, 200, 2, ST77XX_YELLOW, "A = Set Timezone")
+};
 
-// Variables to keep track of the last time displayed
-// This is used to avoid redrawing the the time if it hasn't changed 
-int lastHourDisplayed = -1;
-int lastMinuteDisplayed = -1;
+constexpr ScreenElement grantedScreen[] PROGMEM = {
+  screenText(DISPLAY_WIDTH / 2, 100, 3, ST77XX_GREEN, "ACCESS"),
+  screenText(DISPLAY_WIDTH / 2, 130, 3, ST77XX_GREEN, "GRANTED")
+};
+
+constexpr ScreenElement deniedScreen[] PROGMEM = {
+  screenText(DISPLAY_WIDTH / 2, 100, 3, ST77XX_RED, "ACCESS"),
+  screenText(DISPLAY_WIDTH / 2, 130, 3, ST77XX_RED, "DENIED")
+};
+
+constexpr ScreenElement timezoneScreen[] PROGMEM = {
+  screenText(DISPLAY_WIDTH / 2, 20, 2, ST77XX_CYAN, "TIMEZONE SETUP"),
+  screenRect(TIMEZONE_X, TIMEZONE_Y, TIMEZONE_MAX_WIDTH, TIMEZONE_HEIGHT, ST77XX_BLACK),
+  screenText(DISPLAY_WIDTH / 2, 160, 2, ST77XX_GREEN, "B: +30min"),
+  screenText(DISPLAY_WIDTH / 2, 180, 2, ST77XX_RED, "C: -30min"),
+  screenText(DISPLAY_WIDTH / 2, 200, 2, ST77XX_YELLOW, "D: Save & Exit")
+};
+
+ScreenCompositor<Display> screen(display, ST77XX_BLACK); // Knows which of the screens is on glass
+
+// Boot sequence states
+enum BootState : uint8_t {
+  BOOT_SHOWING_QR_CODE, // QR code on screen until the deadline or the first keypress
+  BOOT_COMPLETE         // Default screen shown, normal operation
+};
+BootState bootState = BOOT_SHOWING_QR_CODE;
+unsigned long qrCodeShownTime = 0; // When the QR code was drawn at boot
+const unsigned long QR_CODE_DISPLAY_TIME = 5000; // Show the QR code for up to 5 seconds at boot
+
+// Variables to keep track of the time displayed
+// This is used to only redraw the characters of the time that changed
+uint32_t clockTimeShown = 0; // Local time on screen, in seconds
+char clockCellsShown[CLOCK_CELLS]; // Character currently on screen in each clock cell (' ' = blank)
+int16_t countdownWidthShown = 0; // Width of the countdown bar on screen
+uint16_t countdownColorShown = ST77XX_BLACK; // Color of the countdown bar on screen
 
 // Variables for user code entry
 char enteredCode[7] = ""; // Buffer for entered code (6 digits + null terminator)
 int codeIndex = 0; // Current position in the entered code
+char codeCellsShown[6]; // Character currently on screen in each code cell (' ' = blank)
 bool codeVerified = false; // Whether the code has been verified
 unsigned long codeEntryStartTime = 0; // When the user started entering a code
 const unsigned long CODE_ENTRY_TIMEOUT = 10000; // 10 seconds to enter code
@@ -61,68 +164,120 @@ bool inTimezoneSetup = false; // Whether we're currently in timezone setup mode
 // Function prototypes
 void displayDefaultScreen();
 void displayTOTPQRCode();
-void base32Encode(const uint8_t* data, int dataLength, char* result, int bufSize);
-void handleKeypadInput();
+bool getTOTPQRModule(uint8_t x, uint8_t y);
+void completeBoot();
+void handleKey(char keyValue);
+void handleKeypadInput(char keyValue);
 void verifyCode();
 void displayCodeEntry();
+void updateCodeEntry();
+void drawCodeCell(int cell, char c);
 void displayVerificationResult(bool success);
+uint32_t getLocalTime();
 void displayTime();
+void updateClock(uint32_t localTime);
+void updateCountdown(uint32_t unixTime);
 void printTextCentered(char* text, int y, uint8_t textSize, uint16_t color);
 void printTextCentered(const __FlashStringHelper* text, int y, uint8_t textSize, uint16_t color);
 void enterTimezoneSetup();
 void handleTimezoneInput(char keyValue);
 void saveTimezoneToEEPROM();
-void loadTimezoneFromEEPROM();
-void initializeEEPROM();
-bool isEEPROMInitialized();
+void saveDriftToEEPROM();
+void loadSettings();
+void saveSettings();
+bool hasLegacySettings();
 void displayTimezoneSetup();
+uint32_t parseCode(const char* code);
+void handleSerialInput();
+void handleTextCommand(char command);
+void handleCommandFrame();
+FrameStatus setClockCommand(const uint8_t* payload, uint8_t length);
+FrameStatus setTimezoneCommand(const uint8_t* payload, uint8_t length);
+FrameStatus loadSecretCommand(const uint8_t* payload, uint8_t length);
+FrameStatus loadBase32SecretCommand(const uint8_t* payload, uint8_t length);
+FrameStatus storeUserKey(uint8_t user, const uint8_t* key, uint8_t keyLength);
+void sendStats();
+void printStats();
+void printHalfHours(int8_t halfHours);
+void startLogDump();
+void sendLogDump();
+#ifdef BENCHMARK
+void runBenchmarks(); // Cycle benchmarks of the bench env, see src/bench
+#endif
 
 void setup() {
   Serial.begin(115200);
-  pinMode(SOLENOID_PIN, OUTPUT);
-  digitalWrite(SOLENOID_PIN, LOW); // Ensure solenoid is off at startup
+  solenoid.begin(); // Ensure solenoid is off at startup
+
+  // Start sampling the keypad first, so keys pressed while the rest of the
+  // hardware and the QR code are set up are queued rather than lost
+  keypad.begin();
 
-  // Initialize EEPROM and load timezone if available
-  if (!isEEPROMInitialized()) {
-    Serial.println(F("Initializing EEPROM"));
-    initializeEEPROM();
+  // Load the timezone and clock drift
+  loadSettings();
+
+  if (fram.begin() && auditLog.begin()) {
+    Serial.print(F("Audit log records: "));
+    Serial.println(auditLog.getCount());
   } else {
-    loadTimezoneFromEEPROM();
+    Serial.println(F("No FRAM, audit log disabled"));
   }
 
-  if (!rtc.begin()) {
+  if (!rtcClock.begin()) {
     Serial.println(F("Couldn't find RTC"));
     Serial.flush();
     while (1) delay(10);
   }
   
   // Initialize the ST7789 TFT display
-  tft.init(240, 240, SPI_MODE3);
-  tft.setRotation(2);
-  tft.fillScreen(ST77XX_BLACK);
+  display.begin();
   
   Serial.println(F("Display initialized"));
-  keypad.useCalibratedThresholds(myThresholds);
   
-  // Display QR code for 5 seconds
+  // Display the QR code, loop() replaces it with the default screen after
+  // QR_CODE_DISPLAY_TIME or as soon as a key is pressed
   displayTOTPQRCode();
-  delay(5000);
-  
-  tft.fillScreen(ST77XX_BLACK);
-  displayDefaultScreen();
+  qrCodeShownTime = millis();
+  bootState = BOOT_SHOWING_QR_CODE;
+
+  Serial.print(F("Ready in "));
+  Serial.print(qrCodeShownTime);
+  Serial.println(F(" ms"));
+
+#ifdef BENCHMARK
+  runBenchmarks();
+#endif
 }
 
 void loop() {
-  if (inTimezoneSetup) {
-    // In timezone setup mode
-    char keyValue = keypad.readKeypadWithTimeout(50);
-    if (keyValue != NO_KEY) {
-      handleTimezoneInput(keyValue);
+  rtcClock.update();
+
+  // Index one more user's codes for the verification window while idle
+  unsigned long indexStart = micros();
+  if (totpVerifier.update(rtcClock.now() / TOTP_TIME_STEP)) {
+    indexBuildMicros += micros() - indexStart;
+  }
+
+  handleSerialInput();
+
+  // Write the audit log and send the dump a little at a time
+  auditLog.flush();
+  sendLogDump();
+
+  // Handle every key pressed since the last pass, the keypad is
+  // sampled in the background so this never waits for a key
+  KeyEvent event;
+  while (keypad.readEvent(event)) {
+    handleKey(event.key);
+  }
+
+  if (bootState == BOOT_SHOWING_QR_CODE) {
+    if (millis() - qrCodeShownTime > QR_CODE_DISPLAY_TIME) {
+      completeBoot();
     }
-  } else {
+  } else if (!inTimezoneSetup) {
     if (!codeVerified) {
       displayTime();
-      handleKeypadInput();
     }
     
     unsigned long currentMillis = millis();
@@ -131,7 +286,6 @@ void loop() {
       // Reset code entry due to timeout
       codeIndex = 0;
       enteredCode[0] = '\0';
-      tft.fillScreen(ST77XX_BLACK);
       displayDefaultScreen();
     }
     
@@ -139,84 +293,183 @@ void loop() {
     if (codeVerified && currentMillis - codeEntryStartTime > 3000) {
       Serial.println(F("Resetting verification status..."));
       codeVerified = false;
-      digitalWrite(SOLENOID_PIN, LOW); // Deactivate solenoid lock
-      tft.fillScreen(ST77XX_BLACK);
+      solenoid.set(false); // Deactivate solenoid lock
       displayDefaultScreen();
     }
   }
-  delay(10);
+}
+
+/**
+ * Get the local time
+ * @return The cached RTC time with the timezone offset applied, in seconds
+ */
+uint32_t getLocalTime() {
+  // Timezone offset is stored in half-hours
+  return rtcClock.now() + timezoneOffset * 30L * 60;
 }
 
 /**
  * Display the current time
- * This function retrieves the current time from the RTC and formats it for display.
- * It also applies the timezone offset to adjust the time accordingly.
+ * This function retrieves the current time from the cached RTC time and
+ * applies the timezone offset to it. The clock and the countdown bar of
+ * the current code are only updated when the second changes. It runs
+ * every pass of loop(), so only the passes that draw open a display scope.
  */
 void displayTime() {
-  // Apply timezone offset (stored in half-hours) converted to seconds
-  long secondsOffset = timezoneOffset * 30 * 60; // half-hours to seconds
-  
-  // Apply the offset to the timestamp and create a new DateTime
-  TimeSpan offset(secondsOffset);
-  DateTime adjusted = rtc.now() + offset;
-  
-  // Extract the adjusted time components
-  int adjustedHour = adjusted.hour();
-  int adjustedMinute = adjusted.minute();
-  
-  // Format time as 00:00PM
-  int hour12 = adjustedHour % 12;
-  if (hour12 == 0) hour12 = 12;  // Adjust for 12 AM/PM
+  uint32_t adjusted = getLocalTime();
+  if (adjusted != clockTimeShown) {
+    DISPLAY_SCOPE();
+    updateClock(adjusted);
+    updateCountdown(rtcClock.now());
+  }
+}
 
-  if (adjustedHour != lastHourDisplayed || adjustedMinute != lastMinuteDisplayed) {
-    lastHourDisplayed = adjustedHour;
-    lastMinuteDisplayed = adjustedMinute;
-    
-    // Update time display
-    char timeStr[9]; // Buffer for time string (format: 00:00PM\0)
-    sprintf(timeStr, "%d:%02d%s", 
-            hour12, 
-            adjustedMinute, 
-            adjustedHour >= 12 ? "PM" : "AM");
-    
-    // Update just the time portion without redrawing the entire screen
-    tft.fillRect(80, 10, 140, 20, ST77XX_BLACK); // Clear time area
-    printTextCentered(timeStr, 10, 2, ST77XX_CYAN);
+/**
+ * Update the clock
+ * This function formats the time as 12:00:00PM, right aligned in the
+ * clock cells so the seconds and AM/PM never move, and compares it with
+ * what each cell shows. Runs of changed cells are redrawn with the digit
+ * font, one address window per cell and nothing cleared. Most seconds
+ * change a single cell, 347 bytes of SPI traffic, a new ten seconds two
+ * and a new minute three to six. That averages 388 bytes per second,
+ * where clearing and redrawing the whole clock every second would take
+ * 6.8 KB.
+ * @param localTime The local time in seconds
+ */
+void updateClock(uint32_t localTime) {
+  DISPLAY_SCOPE();
+  char timeStr[FORMAT_CLOCK_SECONDS_SIZE];
+  uint8_t length = formatClock12Seconds((localTime / 3600) % 24, (localTime / 60) % 60, localTime % 60, timeStr);
+
+  char cells[CLOCK_CELLS + 1];
+  memset(cells, ' ', CLOCK_CELLS - length);
+  memcpy(cells + CLOCK_CELLS - length, timeStr, length + 1);
+
+  for (uint8_t first = 0; first < CLOCK_CELLS; first++) {
+    if (cells[first] == clockCellsShown[first]) {
+      continue;
+    }
+    uint8_t end = first + 1;
+    while (end < CLOCK_CELLS && cells[end] != clockCellsShown[end]) {
+      end++;
+    }
+
+    // Draw the run of changed cells in one call
+    char run[CLOCK_CELLS + 1];
+    memcpy(run, cells + first, end - first);
+    run[end - first] = '\0';
+    display.drawDigits(CLOCK_X + first * CLOCK_CELL_WIDTH, CLOCK_Y, run, CLOCK_TEXT_SIZE, ST77XX_CYAN, ST77XX_BLACK);
+    memcpy(clockCellsShown + first, run, end - first);
+    first = end;
   }
+  clockTimeShown = localTime;
+}
+
+/**
+ * Update the countdown bar
+ * This function shows how much of the current TOTP time step is left,
+ * so a code is not typed just before it expires. The bar shrinks by 6
+ * pixels a second and turns red for the last COUNTDOWN_WARNING seconds.
+ * Only the pixels that change are drawn: most seconds a 6x6 rectangle is
+ * cleared, 83 bytes of SPI traffic. The red bar and the full bar of a new
+ * step are redrawn once each per step. The step is that of the RTC time
+ * corrected by the drift the verifier learned, so the bar runs out when
+ * the phones' codes roll over. It takes the cached RTC time, so it adds
+ * no I2C reads.
+ * @param unixTime The RTC time in seconds
+ */
+void updateCountdown(uint32_t unixTime) {
+  DISPLAY_SCOPE();
+  uint8_t secondsLeft = TOTP_TIME_STEP - totpVerifier.correctedTime(unixTime) % TOTP_TIME_STEP;
+  int16_t width = secondsLeft * (COUNTDOWN_WIDTH / TOTP_TIME_STEP);
+  uint16_t color = secondsLeft <= COUNTDOWN_WARNING ? ST77XX_RED : ST77XX_GREEN;
+
+  // Pixels already in the right color are kept
+  int16_t kept = 0;
+  if (color == countdownColorShown) {
+    kept = width < countdownWidthShown ? width : countdownWidthShown;
+  }
+  if (width > kept) {
+    display.fillRect(COUNTDOWN_X + kept, COUNTDOWN_Y, width - kept, COUNTDOWN_HEIGHT, color);
+  }
+  if (countdownWidthShown > width) {
+    display.fillRect(COUNTDOWN_X + width, COUNTDOWN_Y, countdownWidthShown - width, COUNTDOWN_HEIGHT, ST77XX_BLACK);
+  }
+  countdownWidthShown = width;
+  countdownColorShown = color;
 }
 
 /**
  * Display Default Screen
- * This function clears the screen and and shows the current time.
- * It also displays the code entry prompt. The last displayed hour
- * and minute are reset to ensure the time is updated correctly. This
- * function is called at startup and after code verification.
+ * This function shows the current time and the code entry prompt.
+ * Coming from another screen, only what differs between the screens is
+ * erased and drawn, and the time and code cells are drawn into their
+ * blank areas. If the default screen is already shown, only the code
+ * cells are brought up to date. This function is called at startup,
+ * after code verification and when a code entry times out.
  */
 void displayDefaultScreen() {
-  tft.fillScreen(ST77XX_BLACK);
+  DISPLAY_SCOPE();
+  STACK_SCOPE("displayDefaultScreen");
+  if (screen.isShown(defaultScreen)) {
+    updateCodeEntry();
+    return;
+  }
+  screen.show(defaultScreen);
   
-  lastHourDisplayed = -1; // Reset last hour
-  lastMinuteDisplayed = -1; // Reset last minute
-  displayTime();
+  // The clock and countdown areas are blank
+  memset(clockCellsShown, ' ', sizeof(clockCellsShown));
+  updateClock(getLocalTime());
+  countdownWidthShown = 0;
+  updateCountdown(rtcClock.now());
   
   displayCodeEntry();
 }
 
 /**
- * Handle keypad input
- * This function reads the keypad and processes the input.
+ * Complete the boot sequence
+ * This function replaces the boot QR code with the default screen.
  */
-void handleKeypadInput() {
-  char keyValue = keypad.readKeypadWithTimeout(50);
-  
-  // If no key pressed, return
-  if (keyValue == NO_KEY) {
-    return;
+void completeBoot() {
+  DISPLAY_SCOPE();
+  bootState = BOOT_COMPLETE;
+  displayDefaultScreen();
+}
+
+/**
+ * Handle a key press
+ * This function passes the key to the handler of the current screen.
+ * @param keyValue The key pressed
+ */
+void handleKey(char keyValue) {
+  if (bootState == BOOT_SHOWING_QR_CODE) {
+    // The first key both dismisses the boot QR code and counts as input
+    completeBoot();
   }
-  
+
+  if (inTimezoneSetup) {
+    handleTimezoneInput(keyValue);
+  } else if (!codeVerified) {
+    handleKeypadInput(keyValue);
+  }
+  // Keys pressed while the verification result is shown are ignored
+}
+
+/**
+ * Handle keypad input
+ * This function processes a key pressed on the default screen.
+ * @param keyValue The key pressed
+ */
+void handleKeypadInput(char keyValue) {
+  DISPLAY_SCOPE();
+  STACK_SCOPE("handleKeypadInput");
   // Key pressed - handle it
   Serial.print(F("Key pressed: "));
   Serial.println(keyValue);
+
+#ifdef TFT_SPI_STATS
+  display.resetSpiBytes();
+#endif
   
   // Check for 'A' key for timezone setup
   if (keyValue == 'A') {
@@ -239,7 +492,12 @@ void handleKeypadInput() {
     codeIndex = 0;
     enteredCode[0] = '\0';
   }
-  displayCodeEntry();
+  updateCodeEntry();
+
+#ifdef TFT_SPI_STATS
+  Serial.print(F("SPI bytes: "));
+  Serial.println(display.getSpiBytes());
+#endif
 
   // Verify code when all 6 digits are entered
   if (codeIndex == 6) {
@@ -250,23 +508,34 @@ void handleKeypadInput() {
 /**
  * Verify the entered code
  * This function checks if the entered code matches the current TOTP code.
- * If it matches, access is granted and the solenoid lock is activated.
+ * The code is accepted if it matches any time step within TOTP_WINDOW
+ * steps of the drift-corrected current step. The codes normally come from
+ * the cache filled by loop(), so this is a few integer compares rather than
+ * HMAC computations. If it matches, access is granted and the solenoid
+ * lock is activated.
  */
 void verifyCode() {
-  // Get current TOTP code
-  DateTime now = rtc.now();
-  long GMT = now.unixtime();
-  char* currentCode = totp.getCode(GMT);
-  
-  // Compare entered code with current TOTP code
-  bool success = (strcmp(enteredCode, currentCode) == 0);
+  STACK_SCOPE("verifyCode");
+  uint32_t GMT = rtcClock.now();
+  uint8_t user = TOTP_NO_USER;
+  int8_t offset = totpVerifier.verify(parseCode(enteredCode), GMT / TOTP_TIME_STEP, user);
+  bool success = (offset != TOTP_NO_MATCH);
+
+  // Only queued here, loop() writes it to the FRAM
+  AuditRecord record = {GMT, (uint8_t)(success ? AUDIT_GRANTED : AUDIT_DENIED), user, offset, 0};
+  auditLog.append(record);
   
   Serial.print(F("Entered code: "));
   Serial.println(enteredCode);
-  Serial.print(F("Current TOTP: "));
-  Serial.println(currentCode);
   Serial.print(F("Verification: "));
   Serial.println(success ? F("SUCCESS") : F("FAILED"));
+  if (success) {
+    Serial.print(F("User: "));
+    Serial.println(user);
+    Serial.print(F("Matched step offset: "));
+    Serial.println(offset);
+    saveDriftToEEPROM();
+  }
   
   // Display result
   displayVerificationResult(success);
@@ -279,33 +548,50 @@ void verifyCode() {
 }
 
 /**
- * Display the code entry screen
- * This function shows the user the code they are entering.
- * It also provides instructions for clearing the entry
- * and setting the timezone.
+ * Display the code cells
+ * This function shows the user the code they are entering, in the
+ * code cell area of the default screen. The area must be blank, as it
+ * is when the screen has just been shown, the code cells are then kept
+ * up to date by updateCodeEntry().
  */
 void displayCodeEntry() {
-  tft.fillRect(0, 120, 200, 160, ST77XX_BLACK);
-  
-  // Display prompt
-  printTextCentered(F("Enter Code:"), 50, 2, ST77XX_WHITE);
-  
-  // Display entered code so far
-  tft.setTextSize(4);
-  tft.setTextColor(ST77XX_WHITE);
-  tft.setCursor(45, 120);
-  tft.println(enteredCode);
-  
-  // Add placeholder underscores for remaining digits
-  tft.setTextSize(4);
-  tft.setTextColor(ST77XX_GREY);
-  for (int i = codeIndex; i < 6; i++) {
-    tft.setCursor(45 + i * 24, 120);
-    tft.print("_");
+  DISPLAY_SCOPE();
+  memset(codeCellsShown, ' ', sizeof(codeCellsShown));
+  updateCodeEntry();
+}
+
+/**
+ * Update the code cells
+ * This function compares what each of the six code cells should show
+ * (an entered digit or a placeholder underscore) with what is on screen
+ * and only redraws the cells that changed. Typing a digit redraws a
+ * single cell, one address window of 1355 bytes of SPI traffic instead
+ * of the ~58 KB it took to clear and redraw the whole code entry area.
+ */
+void updateCodeEntry() {
+  DISPLAY_SCOPE();
+  for (int i = 0; i < 6; i++) {
+    char c = (i < codeIndex) ? enteredCode[i] : '_';
+    if (codeCellsShown[i] != c) {
+      drawCodeCell(i, c);
+    }
   }
-  
-  printTextCentered(F("Press * to clear"), 180, 2, ST77XX_GREEN);
-  printTextCentered(F("A = Set Timezone"), 200, 2, ST77XX_YELLOW);
+}
+
+/**
+ * Draw a single code cell
+ * @param cell The index of the cell (0-5)
+ * @param c The character to show, '_' for an empty placeholder
+ */
+void drawCodeCell(int cell, char c) {
+  DISPLAY_SCOPE();
+  int x = CODE_CELL_X + cell * CODE_CELL_WIDTH;
+
+  // The cell is drawn with its background, so it needs no clearing
+  char text[2] = {c, '\0'};
+  display.drawDigits(x, CODE_CELL_Y, text, CODE_TEXT_SIZE, c == '_' ? ST77XX_GREY : ST77XX_WHITE, ST77XX_BLACK);
+
+  codeCellsShown[cell] = c;
 }
 
 /**
@@ -315,15 +601,12 @@ void displayCodeEntry() {
  * @param success True if access is granted, false if denied
  */
 void displayVerificationResult(bool success) {
-  tft.fillScreen(ST77XX_BLACK);
-  
+  DISPLAY_SCOPE();
   if (success) {
-    printTextCentered(F("ACCESS"), 100, 3, ST77XX_GREEN);
-    printTextCentered(F("GRANTED"), 130, 3, ST77XX_GREEN);
-    digitalWrite(SOLENOID_PIN, HIGH); // Activate solenoid lock
+    screen.show(grantedScreen);
+    solenoid.set(true); // Activate solenoid lock
   } else {
-    printTextCentered(F("ACCESS"), 100, 3, ST77XX_RED);
-    printTextCentered(F("DENIED"), 130, 3, ST77XX_RED);
+    screen.show(deniedScreen);
   }
 }
 
@@ -343,33 +626,19 @@ void enterTimezoneSetup() {
  * the keypad. The user can also save the changes and exit the setup.
  */
 void displayTimezoneSetup() {
-  tft.fillScreen(ST77XX_BLACK);
-  
-  printTextCentered(F("TIMEZONE SETUP"), 20, 2, ST77XX_CYAN);
-  
-  // Show current timezone
-  char currentTZ[9];
-  
-  float tzFloat = timezoneOffset / 2.0;
-  if (tzFloat == 0.0) {
-    sprintf(currentTZ, "UTC");
+  DISPLAY_SCOPE();
+  STACK_SCOPE("displayTimezoneSetup");
+  if (screen.isShown(timezoneScreen)) {
+    // Only the offset changed, clear its area
+    display.fillRect(TIMEZONE_X, TIMEZONE_Y, TIMEZONE_MAX_WIDTH, TIMEZONE_HEIGHT, ST77XX_BLACK);
   } else {
-    char tempTZ[6]; // Buffer to store the offset value
-    dtostrf(tzFloat, 2, (timezoneOffset % 2 == 0) ? 0 : 1, tempTZ);
-    if (tzFloat > 0) {
-      sprintf(currentTZ, "UTC+%s", tempTZ);
-    } else {
-      sprintf(currentTZ, "UTC%s", tempTZ);
-    }
+    screen.show(timezoneScreen);
   }
   
-  // Display current timezone in large font
-  printTextCentered(currentTZ, 100, 3, ST77XX_WHITE);
-  
-  // Display instructions
-  printTextCentered(F("B: +30min"), 160, 2, ST77XX_GREEN);
-  printTextCentered(F("C: -30min"), 180, 2, ST77XX_RED);
-  printTextCentered(F("D: Save & Exit"), 200, 2, ST77XX_YELLOW);
+  // Show current timezone in large font, e.g. UTC+5.5
+  char currentTZ[FORMAT_UTC_OFFSET_SIZE];
+  formatUtcOffset(timezoneOffset, currentTZ);
+  printTextCentered(currentTZ, TIMEZONE_Y, TIMEZONE_TEXT_SIZE, ST77XX_WHITE);
 }
 
 /**
@@ -377,11 +646,12 @@ void displayTimezoneSetup() {
  * @param keyValue The key pressed
  */
 void handleTimezoneInput(char keyValue) {
+  DISPLAY_SCOPE();
+  STACK_SCOPE("handleTimezoneInput");
   if (keyValue == 'D') {
     // Save and exit timezone setup
     saveTimezoneToEEPROM();
     inTimezoneSetup = false;
-    tft.fillScreen(ST77XX_BLACK);
     displayDefaultScreen();
     return;
   }
@@ -405,12 +675,35 @@ void handleTimezoneInput(char keyValue) {
 }
 
 /**
- * Check if EEPROM is initialized with the magic marker
- * @return true if EEPROM is initialized, false otherwise
+ * Print a number of half hours over Serial as hours, e.g. +5.5
+ */
+void printHalfHours(int8_t halfHours) {
+  char text[FORMAT_HALF_HOURS_SIZE];
+  formatHalfHours(halfHours, text);
+  Serial.print(text);
+}
+
+/**
+ * Read a byte of the EEPROM for the settings store
  */
-bool isEEPROMInitialized() {
+uint8_t readNvStore(uint16_t address) {
+  return nvStore.read(address);
+}
+
+/**
+ * Write a byte of the EEPROM for the settings store
+ */
+void writeNvStore(uint16_t address, uint8_t value) {
+  nvStore.write(address, value);
+}
+
+/**
+ * Check if the EEPROM holds settings in the layout before the settings record
+ * @return true if the legacy magic marker is present
+ */
+bool hasLegacySettings() {
   for (int i = 0; i < 4; i++) {
-    if (EEPROM.read(EEPROM_MAGIC_ADDR + i) != EEPROM_MAGIC_MARKER[i]) {
+    if (nvStore.read(LEGACY_MAGIC_ADDR + i) != LEGACY_MAGIC_MARKER[i]) {
       return false;
     }
   }
@@ -418,116 +711,169 @@ bool isEEPROMInitialized() {
 }
 
 /**
- * Initialize EEPROM with a magic marker and default timezone
+ * Load the settings from EEPROM
+ * The newest valid record is used. Without one the settings of the
+ * legacy layout are migrated, or the defaults are saved.
  */
-void initializeEEPROM() {
-  // Write the magic marker
-  for (int i = 0; i < 4; i++) {
-    EEPROM.write(EEPROM_MAGIC_ADDR + i, EEPROM_MAGIC_MARKER[i]);
+void loadSettings() {
+  memset(&settings, 0, sizeof(settings));
+  if (!settingsStore.load(&settings)) {
+    if (hasLegacySettings()) {
+      Serial.println(F("Migrating EEPROM settings"));
+      settings.timezoneOffset = (int8_t)nvStore.read(LEGACY_TZ_ADDR);
+      settings.drift = (int8_t)nvStore.read(LEGACY_DRIFT_ADDR);
+    } else {
+      Serial.println(F("Initializing EEPROM"));
+    }
+    settings.version = SETTINGS_VERSION;
+    saveSettings();
   }
-  
-  // Set default timezone to UTC+0
-  EEPROM.write(EEPROM_TZ_ADDR, 0);
-  timezoneOffset = 0;
+
+  timezoneOffset = settings.timezoneOffset;
+  totpVerifier.setDrift(settings.drift);
+  savedDrift = totpVerifier.getDrift();
+
+  Serial.print(F("Loaded timezone offset: "));
+  printHalfHours(timezoneOffset);
+  Serial.println(F(" hours"));
+  Serial.print(F("Loaded clock drift: "));
+  Serial.print(savedDrift);
+  Serial.println(F("/8 steps"));
 }
 
 /**
- * Load the timezone offset from EEPROM
+ * Save the settings to EEPROM
+ * The record goes to the next slot of the ring, unchanged bytes are not written.
  */
-void loadTimezoneFromEEPROM() {
-  // Read timezone value (as signed byte)
-  timezoneOffset = (int8_t)EEPROM.read(EEPROM_TZ_ADDR);
-  
-  Serial.print(F("Loaded timezone offset: "));
-  Serial.print(timezoneOffset / 2.0);
-  Serial.println(F(" hours"));
+void saveSettings() {
+  uint16_t written = settingsStore.save(&settings);
+  if (written == 0) {
+    Serial.println(F("Settings unchanged"));
+    return;
+  }
+
+  Serial.print(F("Settings saved to slot "));
+  Serial.print(settingsStore.getCurrentSlot());
+  Serial.print(F(", bytes written: "));
+  Serial.println(written);
+}
+
+/**
+ * Read the secret of a user for the code index
+ * User 0 is hmacKey, the one shown as a QR code at boot, the others
+ * come from the EEPROM user table.
+ * @param user The user number
+ * @param key Buffer for TOTP_MAX_KEY_LENGTH bytes
+ * @return The length of the secret, 0 if there is no such user
+ */
+uint8_t readUserKey(uint8_t user, uint8_t* key) {
+  if (user == 0) {
+    memcpy(key, hmacKey, hmacKeyLength);
+    return hmacKeyLength;
+  }
+  if (user >= TOTP_MAX_USERS) {
+    return 0;
+  }
+
+  int address = EEPROM_USERS_ADDR + (user - 1) * EEPROM_USER_SIZE;
+  uint8_t keyLength = nvStore.read(address);
+  if (keyLength == 0 || keyLength > EEPROM_USER_KEY_LENGTH) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < keyLength; i++) {
+    key[i] = nvStore.read(address + 1 + i);
+  }
+  return keyLength;
+}
+
+/**
+ * Save the clock drift estimate to EEPROM
+ * Small changes are not written, the estimate moves on every
+ * successful unlock and EEPROM cells wear out.
+ */
+void saveDriftToEEPROM() {
+  int8_t drift = totpVerifier.getDrift();
+  if (abs(drift - savedDrift) < DRIFT_SAVE_THRESHOLD) {
+    return;
+  }
+  settings.drift = drift;
+  saveSettings();
+  savedDrift = drift;
+
+  Serial.print(F("Saved clock drift: "));
+  Serial.print(drift);
+  Serial.println(F("/8 steps"));
 }
 
 /**
  * Save the timezone offset to EEPROM
  */
 void saveTimezoneToEEPROM() {
-  EEPROM.write(EEPROM_TZ_ADDR, (uint8_t)timezoneOffset);
+  settings.timezoneOffset = timezoneOffset;
+  saveSettings();
   
   Serial.print(F("Saved timezone offset: "));
-  Serial.print(timezoneOffset / 2.0);
+  printHalfHours(timezoneOffset);
   Serial.println(F(" hours"));
 }
 
 /**
  * Display the TOTP QR code on the TFT screen
+ * The QR code is generated at compile time, this function only draws
+ * the modules straight from flash.
  */
 void displayTOTPQRCode() {
-  QRCode qrcode;
-  
-  // Define the size of the QR code (1-40, higher means bigger size)
-  uint8_t version = 4;  // Using a larger version for TOTP URI
-  uint8_t qrcodeData[qrcode_getBufferSize(version)];
-  
-  // Create TOTP URI for Google Authenticator
-  // Format: otpauth://totp/Label:User?secret=SECRET&issuer=Issuer
-  char secret[20];
-  base32Encode(hmacKey, 10, secret, 20); // Convert HMAC to Base32 for the URI
-  
-  char uri[100];
-  sprintf(uri, "otpauth://totp/Door:Lock?secret=%s&issuer=TOTPLock", secret);
-  
-  qrcode_initText(&qrcode, qrcodeData, version, 0, uri);
-  
-  // Clear the screen
-  tft.fillScreen(ST77XX_BLACK);
+  DISPLAY_SCOPE();
+  STACK_SCOPE("displayTOTPQRCode");
+  const uint8_t qrModules = QRBitmap<TOTP_QR_VERSION>::size;
+
+  // Clear the screen, it is none of the screens the compositor knows
+  display.fillScreen(ST77XX_BLACK);
+  screen.invalidate();
   
   // Calculate the scale factor and position for centering
   int scale = 4;  // Scale factor for the QR modules
-  int qrSize = qrcode.size * scale;
+  int qrSize = qrModules * scale;
   int xOffset = (240 - qrSize) / 2;
   int yOffset = (240 - qrSize) / 2;
   
-  // Draw the QR code
-  for (uint8_t y = 0; y < qrcode.size; y++) {
-    for (uint8_t x = 0; x < qrcode.size; x++) {
-      if (qrcode_getModule(&qrcode, x, y)) {
-        tft.fillRect(xOffset + x * scale, yOffset + y * scale, scale, scale, ST77XX_WHITE);
+  // Draw the QR code one horizontal run of dark modules at a time, inside a
+  // single SPI transaction, so each run costs one address window instead of
+  // one per module and one transaction per module
+  unsigned long drawStart = micros();
+  display.startWrite();
+  for (uint8_t y = 0; y < qrModules; y++) {
+    uint8_t x = 0;
+    while (x < qrModules) {
+      if (!getTOTPQRModule(x, y)) {
+        x++;
+        continue;
       }
+      uint8_t runStart = x;
+      while (x < qrModules && getTOTPQRModule(x, y)) {
+        x++;
+      }
+      display.writeFillRect(xOffset + runStart * scale, yOffset + y * scale, (x - runStart) * scale, scale, ST77XX_WHITE);
     }
   }
+  display.endWrite();
+
+  Serial.print(F("QR code drawn in "));
+  Serial.print(micros() - drawStart);
+  Serial.println(F(" us"));
   
   printTextCentered(F("Scan with Auth App"), 20, 2, ST77XX_CYAN);
 }
 
 /**
- * Base32 encoding function for TOTP secret
- * @param data The data to encode
- * @param dataLength The length of the data
- * @param result The buffer to store the encoded result
- * @param bufSize The size of the result buffer
+ * Read a module of the TOTP QR code from flash
+ * @param x The column of the module
+ * @param y The row of the module
+ * @return true if the module is dark
  */
-void base32Encode(const uint8_t* data, int dataLength, char* result, int bufSize) {
-
-  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
-  int resultIndex = 0;
-  int bits = 0;
-  int value = 0;
-  
-  for (int i = 0; i < dataLength; i++) {
-    value = (value << 8) | data[i];
-    bits += 8;
-    
-    while (bits >= 5) {
-      if (resultIndex < bufSize - 1) {
-        result[resultIndex++] = chars[(value >> (bits - 5)) & 0x1F];
-      }
-      bits -= 5;
-    }
-  }
-  
-  // If we have remaining bits
-  if (bits > 0 && resultIndex < bufSize - 1) {
-    result[resultIndex++] = chars[(value << (5 - bits)) & 0x1F];
-  }
-  
-  // Null terminate
-  result[resultIndex] = 0;
+bool getTOTPQRModule(uint8_t x, uint8_t y) {
+  uint16_t offset = y * QRBitmap<TOTP_QR_VERSION>::size + x;
+  return pgm_read_byte(&totpQRCode.modules[offset >> 3]) & (0x80 >> (offset & 7));
 }
 
 /**
@@ -538,14 +884,15 @@ void base32Encode(const uint8_t* data, int dataLength, char* result, int bufSize
  * @param color The color of the text
  */
 void printTextCentered(char* text, int y, uint8_t textSize, uint16_t color) {
+  DISPLAY_SCOPE();
   // Calculate text width (each character in default font is 6 pixels wide at size 1)
   int textWidth = strlen(text) * 6 * textSize;
-  int centerX = (tft.width() - textWidth) / 2;
+  int centerX = (display.width() - textWidth) / 2;
   
-  tft.setTextSize(textSize);
-  tft.setTextColor(color);
-  tft.setCursor(centerX, y);
-  tft.println(text);
+  display.setTextSize(textSize);
+  display.setTextColor(color);
+  display.setCursor(centerX, y);
+  display.println(text);
 }
 
 /**
@@ -556,6 +903,7 @@ void printTextCentered(char* text, int y, uint8_t textSize, uint16_t color) {
  * @param color The color of the text
  */
 void printTextCentered(const __FlashStringHelper* text, int y, uint8_t textSize, uint16_t color) {
+  DISPLAY_SCOPE();
   // Flash strings need to be handled differently
   PGM_P p = reinterpret_cast<PGM_P>(text);
   size_t len = 0;
@@ -563,10 +911,315 @@ void printTextCentered(const __FlashStringHelper* text, int y, uint8_t textSize,
   
   // Calculate text width
   int textWidth = len * 6 * textSize;
-  int centerX = (tft.width() - textWidth) / 2;
+  int centerX = (display.width() - textWidth) / 2;
   
-  tft.setTextSize(textSize);
-  tft.setTextColor(color);
-  tft.setCursor(centerX, y);
-  tft.println(text);
-}
\ No newline at end of file
+  display.setTextSize(textSize);
+  display.setTextColor(color);
+  display.setCursor(centerX, y);
+  display.println(text);
+}
+
+/**
+ * Convert an entered code to an integer
+ * @param code The digits entered
+ * @return The code as an integer
+ */
+uint32_t parseCode(const char* code) {
+  uint32_t value = 0;
+  for (int i = 0; code[i] != '\0'; i++) {
+    value = value * 10 + (code[i] - '0');
+  }
+  return value;
+}
+
+/**
+ * Handle commands sent over Serial
+ * Command frames (see lib/Frame/FrameTypes.h) are parsed a byte at a time
+ * as they arrive and at most one is run per pass of loop(), so a service
+ * laptop sending commands never holds up the keypad. Outside a frame,
+ * single characters are commands for the serial monitor:
+ *   s: print statistics
+ *   m: print free SRAM and peak stack use
+ *   l: dump the audit log as binary frames
+ */
+void handleSerialInput() {
+  // A frame that stopped halfway must not swallow the next commands
+  if (!commandParser.isIdle() && millis() - lastSerialByteTime > COMMAND_TIMEOUT) {
+    commandParser.reset();
+  }
+
+  while (Serial.available() > 0) {
+    uint8_t value = Serial.read();
+    lastSerialByteTime = millis();
+    if (commandParser.isIdle() && value != FRAME_SYNC) {
+      handleTextCommand(value);
+    } else if (commandParser.feed(value)) {
+      handleCommandFrame();
+      return;
+    }
+  }
+}
+
+/**
+ * Handle a single-character command from the serial monitor
+ * @param command The character
+ */
+void handleTextCommand(char command) {
+  if (command == 's') {
+    printStats();
+  } else if (command == 'm') {
+    StackMonitor::printReport(Serial);
+  } else if (command == 'l') {
+    startLogDump();
+  }
+}
+
+/**
+ * Run the command frame commandParser just completed and send the reply
+ */
+void handleCommandFrame() {
+  uint8_t type = commandParser.getType();
+  const uint8_t* payload = commandParser.getPayload();
+  uint8_t length = commandParser.getLength();
+
+  FrameStatus status;
+  switch (type) {
+    case FRAME_CMD_SET_CLOCK:
+      status = setClockCommand(payload, length);
+      break;
+    case FRAME_CMD_SET_TIMEZONE:
+      status = setTimezoneCommand(payload, length);
+      break;
+    case FRAME_CMD_LOAD_SECRET:
+      status = loadSecretCommand(payload, length);
+      break;
+    case FRAME_CMD_LOAD_SECRET_BASE32:
+      status = loadBase32SecretCommand(payload, length);
+      break;
+    case FRAME_CMD_GET_STATS:
+      sendStats();
+      return;
+    case FRAME_CMD_DUMP_LOG:
+      status = auditLog.isReady() ? FRAME_OK : FRAME_FAILED;
+      break;
+    default:
+      status = FRAME_UNKNOWN;
+      break;
+  }
+
+  uint8_t reply = status;
+  writeFrame(Serial, type | FRAME_REPLY, &reply, 1);
+  if (type == FRAME_CMD_DUMP_LOG && status == FRAME_OK) {
+    startLogDump();
+  }
+}
+
+/**
+ * Set the RTC
+ * @param payload The unix time, 4 bytes
+ */
+FrameStatus setClockCommand(const uint8_t* payload, uint8_t length) {
+  if (length != 4) {
+    return FRAME_BAD_LENGTH;
+  }
+  uint32_t unixTime = payload[0] | (uint32_t)payload[1] << 8 | (uint32_t)payload[2] << 16 | (uint32_t)payload[3] << 24;
+  rtcClock.adjust(unixTime);
+
+  Serial.print(F("Clock set to "));
+  Serial.println(unixTime);
+  return FRAME_OK;
+}
+
+/**
+ * Set and save the timezone
+ * @param payload The offset in half-hours, 1 signed byte
+ */
+FrameStatus setTimezoneCommand(const uint8_t* payload, uint8_t length) {
+  if (length != 1) {
+    return FRAME_BAD_LENGTH;
+  }
+  int8_t offset = (int8_t)payload[0];
+  if (offset < -24 || offset > 28) {
+    return FRAME_BAD_VALUE;
+  }
+  timezoneOffset = offset;
+  saveTimezoneToEEPROM();
+  return FRAME_OK;
+}
+
+/**
+ * Store or remove the secret of a user
+ * @param payload The user number and the secret, no secret removes the user
+ */
+FrameStatus loadSecretCommand(const uint8_t* payload, uint8_t length) {
+  if (length < 1 || length > 1 + EEPROM_USER_KEY_LENGTH) {
+    return FRAME_BAD_LENGTH;
+  }
+  return storeUserKey(payload[0], payload + 1, length - 1);
+}
+
+/**
+ * Store the secret of a user given in base32, as authenticator apps show it
+ * @param payload The user number and the base32 secret
+ */
+FrameStatus loadBase32SecretCommand(const uint8_t* payload, uint8_t length) {
+  char text[FRAME_PARSER_SIZE];
+  if (length < 2) {
+    return FRAME_BAD_LENGTH;
+  }
+  memcpy(text, payload + 1, length - 1);
+  text[length - 1] = '\0';
+
+  uint8_t key[EEPROM_USER_KEY_LENGTH];
+  int keyLength = Base32::decode(text, key, sizeof(key));
+  if (keyLength <= 0) {
+    return FRAME_BAD_VALUE;
+  }
+  return storeUserKey(payload[0], key, keyLength);
+}
+
+/**
+ * Store or remove the secret of a user in the EEPROM user table
+ * Only bytes that differ are written, and the code index is rebuilt. Users
+ * the code index does not hold are refused, they could never unlock.
+ * @param user The user number, 1 to TOTP_MAX_USERS - 1
+ * @param key The secret
+ * @param keyLength The length of the secret, 0 removes the user
+ */
+FrameStatus storeUserKey(uint8_t user, const uint8_t* key, uint8_t keyLength) {
+  if (user == 0 || user >= TOTP_MAX_USERS) {
+    return FRAME_BAD_VALUE;
+  }
+
+  int address = EEPROM_USERS_ADDR + (user - 1) * EEPROM_USER_SIZE;
+  if (nvStore.read(address) != keyLength) {
+    nvStore.write(address, keyLength);
+  }
+  for (uint8_t i = 0; i < keyLength; i++) {
+    if (nvStore.read(address + 1 + i) != key[i]) {
+      nvStore.write(address + 1 + i, key[i]);
+    }
+  }
+  totpCache.clear();
+
+  Serial.print(keyLength > 0 ? F("Secret loaded for user ") : F("Removed user "));
+  Serial.println(user);
+  return FRAME_OK;
+}
+
+/**
+ * Send the statistics as the reply to FRAME_CMD_GET_STATS
+ */
+void sendStats() {
+  uint32_t hits = totpCache.getHits();
+  uint32_t misses = totpCache.getMisses();
+  uint32_t now = rtcClock.now();
+  uint16_t records = auditLog.getCount();
+  uint16_t dropped = auditLog.getDropped();
+  uint16_t minFreeRam = StackMonitor::getMinFreeRam();
+  uint8_t payload[1 + FRAME_STATS_SIZE] = {
+    FRAME_OK,
+    (uint8_t)hits, (uint8_t)(hits >> 8), (uint8_t)(hits >> 16), (uint8_t)(hits >> 24),
+    (uint8_t)misses, (uint8_t)(misses >> 8), (uint8_t)(misses >> 16), (uint8_t)(misses >> 24),
+    (uint8_t)totpVerifier.getDrift(),
+    (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24),
+    (uint8_t)records, (uint8_t)(records >> 8),
+    (uint8_t)dropped, (uint8_t)(dropped >> 8),
+    keypad.getDroppedEvents(),
+    (uint8_t)minFreeRam, (uint8_t)(minFreeRam >> 8)
+  };
+  writeFrame(Serial, FRAME_CMD_GET_STATS | FRAME_REPLY, payload, sizeof(payload));
+}
+
+/**
+ * Print statistics over Serial
+ */
+void printStats() {
+  STACK_SCOPE("printStats");
+  Serial.print(F("TOTP cache hits: "));
+  Serial.print(totpCache.getHits());
+  Serial.print(F(", misses: "));
+  Serial.println(totpCache.getMisses());
+  Serial.print(F("TOTP index build time per step: "));
+  Serial.print(totpCache.getIndexedSteps() ? indexBuildMicros / totpCache.getIndexedSteps() : 0);
+  Serial.println(F(" us"));
+  Serial.print(F("Clock drift: "));
+  Serial.print(totpVerifier.getDrift());
+  Serial.println(F("/8 steps"));
+  Serial.print(F("Matches per step offset:"));
+  for (int8_t offset = -TOTP_WINDOW; offset <= TOTP_WINDOW; offset++) {
+    Serial.print(' ');
+    Serial.print(offset);
+    Serial.print('=');
+    Serial.print(totpVerifier.getMatches(offset));
+  }
+  Serial.println();
+  Serial.print(F("RTC I2C reads saved per hour: "));
+  Serial.println(rtcClock.getI2CReadsSavedPerHour());
+  Serial.print(F("Keypad events dropped: "));
+  Serial.println(keypad.getDroppedEvents());
+  Serial.print(F("Audit log records: "));
+  Serial.print(auditLog.getCount());
+  Serial.print('/');
+  Serial.print(auditLog.getCapacity());
+  Serial.print(F(", dropped: "));
+  Serial.println(auditLog.getDropped());
+  Serial.print(F("Minimum free SRAM: "));
+  Serial.print(StackMonitor::getMinFreeRam());
+  Serial.println(F(" bytes"));
+}
+
+/**
+ * Read bytes of the FRAM for the audit log
+ */
+bool readFram(uint16_t address, uint8_t* data, uint8_t length) {
+  return fram.read(address, data, length);
+}
+
+/**
+ * Write bytes of the FRAM for the audit log
+ */
+bool writeFram(uint16_t address, const uint8_t* data, uint8_t length) {
+  return fram.write(address, data, length);
+}
+
+/**
+ * Start sending the audit log over Serial
+ * The records follow a FRAME_LOG_START frame, sendLogDump() sends them
+ * from loop() as the Serial buffer drains. tools/auditlog/decode_log.py
+ * decodes the dump.
+ */
+void startLogDump() {
+  uint16_t count = auditLog.getCount();
+  uint16_t capacity = auditLog.getCapacity();
+  uint16_t dropped = auditLog.getDropped();
+  uint8_t payload[6] = {
+    (uint8_t)count, (uint8_t)(count >> 8),
+    (uint8_t)capacity, (uint8_t)(capacity >> 8),
+    (uint8_t)dropped, (uint8_t)(dropped >> 8)
+  };
+  writeFrame(Serial, FRAME_LOG_START, payload, sizeof(payload));
+  logDumping = true;
+  logDumpIndex = 0;
+}
+
+/**
+ * Send the audit log records that fit in the Serial buffer
+ * Never waits for Serial, so key presses are handled while the log is sent.
+ */
+void sendLogDump() {
+  while (logDumping && Serial.availableForWrite() >= FRAME_OVERHEAD + AUDIT_RECORD_SIZE) {
+    AuditRecord record;
+    if (!auditLog.read(logDumpIndex, record)) {
+      uint8_t payload[2] = {(uint8_t)logDumpIndex, (uint8_t)(logDumpIndex >> 8)};
+      writeFrame(Serial, FRAME_LOG_END, payload, sizeof(payload));
+      logDumping = false;
+      return;
+    }
+
+    uint8_t payload[AUDIT_RECORD_SIZE];
+    record.encode(payload);
+    writeFrame(Serial, FRAME_LOG_RECORD, payload, sizeof(payload));
+    logDumpIndex++;
+  }
+}
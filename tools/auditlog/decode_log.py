@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Dump and decode the audit log of a TOTP Lock.
+
+The firmware answers the serial command 'l' with binary frames mixed into
+its text log:
+
+    0xA5, type, payload length, payload, CRC-16/CCITT-FALSE of type,
+    length and payload (low byte first)
+
+A FRAME_LOG_START frame (record count, capacity, dropped records) comes
+first, then one FRAME_LOG_RECORD frame per record, oldest first, then a
+FRAME_LOG_END frame. Records are 8 bytes, little endian: unix time (4),
+event (1), user (1), time step offset (1, signed), flags (1).
+
+Usage:
+    decode_log.py --port /dev/ttyUSB0 [--baud 115200] [--raw capture.bin]
+    decode_log.py capture.bin
+
+Prints the records as CSV. Reading from a port needs pyserial.
+"""
+
+import argparse
+import struct
+import sys
+import time
+from datetime import datetime, timezone
+
+FRAME_SYNC = 0xA5
+FRAME_LOG_START = 0x10
+FRAME_LOG_RECORD = 0x11
+FRAME_LOG_END = 0x12
+
+EVENTS = {0: "denied", 1: "granted"}
+NO_USER = 0xFF
+NO_MATCH = -128
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, the same as lib/Crc16."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frames(data):
+    """Yield (type, payload) for every frame with a good CRC, skipping text."""
+    i = 0
+    while i + 5 <= len(data):
+        if data[i] != FRAME_SYNC:
+            i += 1
+            continue
+        frame_type, length = data[i + 1], data[i + 2]
+        end = i + 3 + length + 2
+        if end > len(data):
+            break
+        payload = data[i + 3:i + 3 + length]
+        (crc,) = struct.unpack_from("<H", data, i + 3 + length)
+        if crc16(bytes([frame_type, length]) + payload) == crc:
+            yield frame_type, payload
+            i = end
+        else:
+            i += 1
+
+
+def read_port(port, baud, timeout):
+    """Send the dump command and read until the FRAME_LOG_END frame."""
+    import serial
+
+    with serial.Serial(port, baud, timeout=0.2) as link:
+        time.sleep(2)  # Opening the port resets the board
+        link.reset_input_buffer()
+        link.write(b"l")
+        data = bytearray()
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            data += link.read(4096)
+            if any(frame_type == FRAME_LOG_END for frame_type, _ in frames(data)):
+                break
+        return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("capture", nargs="?", help="file holding captured serial output")
+    parser.add_argument("--port", help="serial port of the lock")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=30, help="seconds to wait for the dump")
+    parser.add_argument("--raw", help="also save the bytes read from the port")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.timeout)
+        if args.raw:
+            with open(args.raw, "wb") as out:
+                out.write(data)
+    elif args.capture:
+        with open(args.capture, "rb") as capture:
+            data = capture.read()
+    else:
+        parser.error("give a capture file or --port")
+
+    print("index,time,event,user,offset")
+    index = 0
+    expected = None
+    complete = False
+    for frame_type, payload in frames(data):
+        if frame_type == FRAME_LOG_START:
+            expected, capacity, dropped = struct.unpack("<HHH", payload)
+            print(f"# {expected} of {capacity} records, {dropped} dropped", file=sys.stderr)
+        elif frame_type == FRAME_LOG_RECORD:
+            unix_time, event, user, offset, _flags = struct.unpack("<IBBbB", payload)
+            stamp = datetime.fromtimestamp(unix_time, timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ")
+            print(",".join([
+                str(index),
+                stamp,
+                EVENTS.get(event, str(event)),
+                "" if user == NO_USER else str(user),
+                "" if offset == NO_MATCH else str(offset),
+            ]))
+            index += 1
+        elif frame_type == FRAME_LOG_END:
+            complete = True
+            break
+
+    if not complete or (expected is not None and index != expected):
+        print(f"# incomplete dump: {index} records decoded", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
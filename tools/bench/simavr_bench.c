@@ -0,0 +1,149 @@
+/*
+ * Cycle benchmark harness for the bench firmware
+ *
+ * Runs the firmware built by the bench env under simavr and turns the
+ * marker writes of src/bench/Benchmark.cpp into cycle counts:
+ *   GPIOR1  name of the next benchmark, one character per write
+ *   GPIOR0  0x01 starts it, 0x00 stops it, 0xFF ends the run
+ *   GPIOR2  bytes the display would receive over SPI
+ * The cycles of an empty benchmark named _overhead are subtracted from
+ * every other one. Results are written as JSON.
+ *
+ * Usage: simavr_bench firmware.elf [results.json]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+
+#define F_CPU 16000000UL
+#define CYCLE_LIMIT (F_CPU * 600) /* Ten simulated minutes */
+
+/* Data space addresses of the marker registers on the ATmega328P */
+#define GPIOR0_ADDR 0x3E
+#define GPIOR1_ADDR 0x4A
+#define GPIOR2_ADDR 0x4B
+
+#define MARKER_END 0x00
+#define MARKER_BEGIN 0x01
+#define MARKER_DONE 0xFF
+
+#define MAX_BENCHMARKS 32
+#define MAX_NAME_LENGTH 40
+
+struct benchmark {
+  char name[MAX_NAME_LENGTH];
+  avr_cycle_count_t cycles;
+  unsigned long spi_bytes;
+};
+
+static struct benchmark benchmarks[MAX_BENCHMARKS];
+static int benchmark_count = 0;
+static char pending_name[MAX_NAME_LENGTH];
+static size_t pending_length = 0;
+static avr_cycle_count_t start_cycle = 0;
+static unsigned long spi_bytes = 0;
+static int running = 0;
+static int done = 0;
+
+static void on_name(avr_t* avr, avr_io_addr_t addr, uint8_t value, void* param) {
+  if (pending_length < MAX_NAME_LENGTH - 1) {
+    pending_name[pending_length++] = value;
+    pending_name[pending_length] = '\0';
+  }
+}
+
+static void on_spi_sink(avr_t* avr, avr_io_addr_t addr, uint8_t value, void* param) {
+  spi_bytes++;
+}
+
+static void on_marker(avr_t* avr, avr_io_addr_t addr, uint8_t value, void* param) {
+  if (value == MARKER_BEGIN) {
+    running = 1;
+    spi_bytes = 0;
+    start_cycle = avr->cycle;
+  } else if (value == MARKER_END && running && benchmark_count < MAX_BENCHMARKS) {
+    struct benchmark* result = &benchmarks[benchmark_count++];
+    strcpy(result->name, pending_name);
+    result->cycles = avr->cycle - start_cycle;
+    result->spi_bytes = spi_bytes;
+    running = 0;
+    pending_length = 0;
+    pending_name[0] = '\0';
+  } else if (value == MARKER_DONE) {
+    done = 1;
+  }
+}
+
+static void write_results(FILE* out) {
+  avr_cycle_count_t overhead = 0;
+  for (int i = 0; i < benchmark_count; i++) {
+    if (strcmp(benchmarks[i].name, "_overhead") == 0) {
+      overhead = benchmarks[i].cycles;
+    }
+  }
+
+  fprintf(out, "{\n  \"mcu\": \"atmega328p\",\n  \"f_cpu\": %lu,\n  \"overhead_cycles\": %llu,\n  \"benchmarks\": [",
+          F_CPU, (unsigned long long)overhead);
+  int first = 1;
+  for (int i = 0; i < benchmark_count; i++) {
+    if (benchmarks[i].name[0] == '_') {
+      continue;
+    }
+    avr_cycle_count_t cycles = benchmarks[i].cycles - overhead;
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"cycles\": %llu, \"us\": %.1f, \"spi_bytes\": %lu}", first ? "" : ",",
+            benchmarks[i].name, (unsigned long long)cycles, cycles * 1e6 / F_CPU, benchmarks[i].spi_bytes);
+    first = 0;
+  }
+  fprintf(out, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s firmware.elf [results.json]\n", argv[0]);
+    return 2;
+  }
+
+  elf_firmware_t firmware;
+  memset(&firmware, 0, sizeof(firmware));
+  if (elf_read_firmware(argv[1], &firmware) != 0) {
+    fprintf(stderr, "%s: cannot read firmware\n", argv[1]);
+    return 1;
+  }
+  firmware.frequency = F_CPU;
+
+  avr_t* avr = avr_make_mcu_by_name("atmega328p");
+  if (avr == NULL) {
+    fprintf(stderr, "simavr has no atmega328p core\n");
+    return 1;
+  }
+  avr_init(avr);
+  avr_load_firmware(avr, &firmware);
+
+  avr_register_io_write(avr, GPIOR0_ADDR, on_marker, NULL);
+  avr_register_io_write(avr, GPIOR1_ADDR, on_name, NULL);
+  avr_register_io_write(avr, GPIOR2_ADDR, on_spi_sink, NULL);
+
+  int state = cpu_Running;
+  while (!done && state != cpu_Done && state != cpu_Crashed && avr->cycle < CYCLE_LIMIT) {
+    state = avr_run(avr);
+  }
+  if (!done) {
+    fprintf(stderr, "firmware stopped before finishing the benchmarks (state %d, cycle %llu)\n", state,
+            (unsigned long long)avr->cycle);
+    return 1;
+  }
+
+  FILE* out = stdout;
+  if (argc == 3 && (out = fopen(argv[2], "w")) == NULL) {
+    perror(argv[2]);
+    return 1;
+  }
+  write_results(out);
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
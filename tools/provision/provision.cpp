@@ -0,0 +1,380 @@
+// Provisioning tool: generates user secrets for doors and writes, per door,
+// an EEPROM image in the firmware's layout and the otpauth QR codes to scan.
+// Built from the same secret encoding, QR encoder and TOTP code as the
+// firmware, see the Makefile.
+//
+// Usage: provision [options] door...
+//   -o, --out <dir>          where the files go (default .)
+//   -b, --batch <file>       also provision the doors listed in a file, one per line
+//   -u, --users <n>          users per door (default 1, these are users 1 and up, at most 32)
+//   -k, --key-length <n>     secret bytes (default 20)
+//   -t, --timezone <n>       timezone offset in half-hours (default 0)
+//   -i, --issuer <name>      issuer shown by the authenticator app (default TOTPLock)
+//   -s, --scale <n>          pixels per QR module (default 8)
+//
+// For each door it writes <door>.eep, flashed with
+//   avrdude -p m328p -c arduino -P <port> -U eeprom:w:<door>.eep:i
+// and <door>-user<n>.png per user. secrets.csv lists every secret, keep it safe.
+
+#include <Base32.h>
+#include <ConfigStore.h>
+#include <Otpauth.h>
+#include <StaticQRCode.h>
+#include <TotpCodeCache.h>
+#include <TotpEngine.h>
+#include <EepromLayout.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#define DEFAULT_ISSUER "TOTPLock"
+#define QR_QUIET_ZONE 4 // Light modules around the code, required by the QR standard
+#define HEX_LINE_BYTES 16
+
+static_assert(TOTP_MAX_USERS == EEPROM_USER_COUNT + 1,
+              "The tool must be built with the TOTP_MAX_USERS of the firmware, see the Makefile");
+
+struct Options {
+  std::string outDir = ".";
+  int users = 1;
+  int keyLength = EEPROM_USER_KEY_LENGTH;
+  int timezone = 0;
+  std::string issuer = DEFAULT_ISSUER;
+  int scale = 8;
+};
+
+// The EEPROM image being built, ConfigStore writes the settings into it
+static uint8_t image[EEPROM_LAYOUT_SIZE];
+
+static uint8_t readImage(uint16_t address) {
+  return image[address];
+}
+
+static void writeImage(uint16_t address, uint8_t value) {
+  image[address] = value;
+}
+
+static void die(const char* message, const std::string& detail = "") {
+  fprintf(stderr, "provision: %s%s%s\n", message, detail.empty() ? "" : ": ", detail.c_str());
+  exit(1);
+}
+
+/**
+ * Fill a buffer with random bytes from the kernel
+ */
+static void randomBytes(uint8_t* buffer, size_t length) {
+  FILE* random = fopen("/dev/urandom", "rb");
+  if (random == nullptr || fread(buffer, 1, length, random) != length) {
+    die("cannot read /dev/urandom");
+  }
+  fclose(random);
+}
+
+/**
+ * Check that a door name is safe in a file name and an otpauth label
+ */
+static bool validDoorName(const std::string& name) {
+  if (name.empty() || name.size() > 24) {
+    return false;
+  }
+  for (char c : name) {
+    if (!(isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.')) {
+      return false;
+    }
+  }
+  return name[0] != '.';
+}
+
+/**
+ * Write the image as Intel HEX, the format avrdude expects for .eep files
+ * Every byte is written, erased ones too, so nothing of an earlier
+ * configuration survives in the settings ring.
+ */
+static bool writeIntelHex(const std::string& path) {
+  FILE* out = fopen(path.c_str(), "w");
+  if (out == nullptr) {
+    return false;
+  }
+  for (unsigned address = 0; address < EEPROM_LAYOUT_SIZE; address += HEX_LINE_BYTES) {
+    uint8_t sum = HEX_LINE_BYTES + (address >> 8) + (address & 0xFF);
+    fprintf(out, ":%02X%04X00", HEX_LINE_BYTES, address);
+    for (unsigned i = 0; i < HEX_LINE_BYTES; i++) {
+      fprintf(out, "%02X", image[address + i]);
+      sum += image[address + i];
+    }
+    fprintf(out, "%02X\n", (uint8_t)-sum);
+  }
+  fprintf(out, ":00000001FF\n");
+  return fclose(out) == 0;
+}
+
+/**
+ * A QR code as a square of modules, true is dark
+ */
+struct QRModules {
+  int size = 0;
+  std::vector<bool> dark;
+};
+
+/**
+ * Encode text in the smallest QR code version from VERSION up that holds it
+ */
+template <uint8_t VERSION>
+static bool encodeQR(const char* text, QRModules& qr) {
+  QRBitmap<VERSION> bitmap = qrEncodeText<VERSION>(text, QR_ECC_LOW);
+  if (!bitmap.valid) {
+    return encodeQR<VERSION + 1>(text, qr);
+  }
+  qr.size = bitmap.size;
+  qr.dark.resize(qr.size * qr.size);
+  for (int y = 0; y < qr.size; y++) {
+    for (int x = 0; x < qr.size; x++) {
+      qr.dark[y * qr.size + x] = bitmap.getModule(x, y);
+    }
+  }
+  return true;
+}
+
+template <>
+bool encodeQR<QR_MAX_VERSION + 1>(const char*, QRModules&) {
+  return false;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back(value >> 24);
+  out.push_back(value >> 16);
+  out.push_back(value >> 8);
+  out.push_back(value);
+}
+
+static void appendChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data) {
+  appendBigEndian(png, data.size());
+  size_t start = png.size();
+  png.insert(png.end(), type, type + 4);
+  png.insert(png.end(), data.begin(), data.end());
+  appendBigEndian(png, crc32(png.data() + start, png.size() - start));
+}
+
+/**
+ * Write a QR code as a 1-bit grayscale PNG
+ * The pixels go in uncompressed deflate blocks, which needs no zlib and
+ * is small enough at one bit per pixel.
+ */
+static bool writePng(const std::string& path, const QRModules& qr, int scale) {
+  int width = (qr.size + 2 * QR_QUIET_ZONE) * scale;
+  int rowBytes = (width + 7) / 8;
+
+  std::vector<uint8_t> pixels; // Each row is a filter byte (0, none) and the bits
+  for (int y = 0; y < width; y++) {
+    pixels.push_back(0);
+    int moduleY = y / scale - QR_QUIET_ZONE;
+    for (int byte = 0; byte < rowBytes; byte++) {
+      uint8_t bits = 0;
+      for (int bit = 0; bit < 8; bit++) {
+        int x = byte * 8 + bit;
+        int moduleX = x / scale - QR_QUIET_ZONE;
+        bool dark = x < width && moduleX >= 0 && moduleX < qr.size && moduleY >= 0 && moduleY < qr.size &&
+                    qr.dark[moduleY * qr.size + moduleX];
+        bits = bits << 1 | (dark ? 0 : 1);
+      }
+      pixels.push_back(bits);
+    }
+  }
+
+  std::vector<uint8_t> zlib = {0x78, 0x01};
+  uint32_t a = 1, b = 0;
+  for (size_t offset = 0; offset < pixels.size() || offset == 0;) {
+    size_t length = pixels.size() - offset < 65535 ? pixels.size() - offset : 65535;
+    bool last = offset + length == pixels.size();
+    zlib.push_back(last ? 1 : 0);
+    zlib.push_back(length);
+    zlib.push_back(length >> 8);
+    zlib.push_back(~length);
+    zlib.push_back(~length >> 8);
+    for (size_t i = 0; i < length; i++) {
+      uint8_t value = pixels[offset + i];
+      zlib.push_back(value);
+      a = (a + value) % 65521;
+      b = (b + a) % 65521;
+    }
+    offset += length;
+    if (last) {
+      break;
+    }
+  }
+  appendBigEndian(zlib, b << 16 | a);
+
+  std::vector<uint8_t> header;
+  appendBigEndian(header, width);
+  appendBigEndian(header, width);
+  header.insert(header.end(), {1, 0, 0, 0, 0}); // 1-bit grayscale, deflate, no filter, no interlace
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  appendChunk(png, "IHDR", header);
+  appendChunk(png, "IDAT", zlib);
+  appendChunk(png, "IEND", {});
+
+  FILE* out = fopen(path.c_str(), "wb");
+  if (out == nullptr) {
+    return false;
+  }
+  bool written = fwrite(png.data(), 1, png.size(), out) == png.size();
+  return fclose(out) == 0 && written;
+}
+
+/**
+ * Provision one door: its secrets, EEPROM image and QR codes
+ */
+static void provisionDoor(const std::string& door, const Options& options, FILE* manifest) {
+  if (!validDoorName(door)) {
+    die("door names are 1-24 letters, digits, '-', '_' or '.'", door);
+  }
+
+  memset(image, 0xFF, sizeof(image));
+  ConfigStore settingsStore(SETTINGS_ADDR, SETTINGS_REGION_SIZE, sizeof(Settings), readImage, writeImage);
+  Settings settings;
+  memset(&settings, 0, sizeof(settings));
+  settings.version = SETTINGS_VERSION;
+  settings.timezoneOffset = options.timezone;
+  settingsStore.save(&settings);
+
+  for (int user = 1; user <= options.users; user++) {
+    uint8_t key[EEPROM_USER_KEY_LENGTH];
+    randomBytes(key, options.keyLength);
+
+    int address = EEPROM_USERS_ADDR + (user - 1) * EEPROM_USER_SIZE;
+    image[address] = options.keyLength;
+    memcpy(image + address + 1, key, options.keyLength);
+
+    std::string label = door + ":user" + std::to_string(user);
+    OtpauthUri uri = makeOtpauthUri(key, options.keyLength, label.c_str(), options.issuer.c_str());
+    if (uri.length == 0) {
+      die("the otpauth URI is too long, use a shorter door name or issuer", door);
+    }
+    QRModules qr;
+    if (!encodeQR<QR_MIN_VERSION>(uri.text, qr)) {
+      die("the otpauth URI does not fit in a QR code", door);
+    }
+    std::string png = options.outDir + "/" + door + "-user" + std::to_string(user) + ".png";
+    if (!writePng(png, qr, options.scale)) {
+      die("cannot write", png);
+    }
+
+    char secret[OTPAUTH_SECRET_MAX_LENGTH];
+    Base32::encode(key, options.keyLength, secret, sizeof(secret));
+    fprintf(manifest, "%s,%d,%s,%s\n", door.c_str(), user, secret, uri.text);
+
+    // The code the phone should show right now, to check a scanned code
+    TotpEngine engine;
+    engine.begin(key, options.keyLength);
+    char code[TOTP_DIGITS + 1];
+    TotpEngine::formatCode(engine.getCode(time(nullptr)), code);
+    printf("%s user %d: %s (code now %s)\n", door.c_str(), user, png.c_str(), code);
+  }
+
+  std::string eep = options.outDir + "/" + door + ".eep";
+  if (!writeIntelHex(eep)) {
+    die("cannot write", eep);
+  }
+  printf("%s: %s\n", door.c_str(), eep.c_str());
+}
+
+/**
+ * Read door names from a file, one per line, # starts a comment
+ */
+static void readBatch(const char* path, std::vector<std::string>& doors) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    die("cannot read", path);
+  }
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), file)) {
+    std::string line(buffer);
+    line = line.substr(0, line.find('#'));
+    size_t first = line.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos) {
+      doors.push_back(line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1));
+    }
+  }
+  fclose(file);
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [options] door...\n"
+          "  -o, --out <dir>        where the files go (default .)\n"
+          "  -b, --batch <file>     also provision the doors listed in a file, one per line\n"
+          "  -u, --users <n>        users per door (default 1, max %d)\n"
+          "  -k, --key-length <n>   secret bytes (default %d, 10-%d)\n"
+          "  -t, --timezone <n>     timezone offset in half-hours (default 0, -24 to 28)\n"
+          "  -i, --issuer <name>    issuer shown by the authenticator app (default " DEFAULT_ISSUER ")\n"
+          "  -s, --scale <n>        pixels per QR module (default 8)\n",
+          program, TOTP_MAX_USERS - 1, EEPROM_USER_KEY_LENGTH, EEPROM_USER_KEY_LENGTH);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  static const option longOptions[] = {
+    {"out", required_argument, nullptr, 'o'},
+    {"batch", required_argument, nullptr, 'b'},
+    {"users", required_argument, nullptr, 'u'},
+    {"key-length", required_argument, nullptr, 'k'},
+    {"timezone", required_argument, nullptr, 't'},
+    {"issuer", required_argument, nullptr, 'i'},
+    {"scale", required_argument, nullptr, 's'},
+    {nullptr, 0, nullptr, 0}
+  };
+
+  Options options;
+  std::vector<std::string> doors;
+  int option;
+  while ((option = getopt_long(argc, argv, "o:b:u:k:t:i:s:", longOptions, nullptr)) != -1) {
+    switch (option) {
+      case 'o': options.outDir = optarg; break;
+      case 'b': readBatch(optarg, doors); break;
+      case 'u': options.users = atoi(optarg); break;
+      case 'k': options.keyLength = atoi(optarg); break;
+      case 't': options.timezone = atoi(optarg); break;
+      case 'i': options.issuer = optarg; break;
+      case 's': options.scale = atoi(optarg); break;
+      default: usage(argv[0]);
+    }
+  }
+  for (int i = optind; i < argc; i++) {
+    doors.push_back(argv[i]);
+  }
+
+  if (doors.empty() || options.users < 1 || options.users >= TOTP_MAX_USERS || options.keyLength < 10 ||
+      options.keyLength > EEPROM_USER_KEY_LENGTH || options.timezone < -24 || options.timezone > 28 ||
+      options.scale < 1) {
+    usage(argv[0]);
+  }
+
+  std::string manifestPath = options.outDir + "/secrets.csv";
+  FILE* manifest = fopen(manifestPath.c_str(), "a");
+  if (manifest == nullptr) {
+    die("cannot write", manifestPath);
+  }
+  for (const std::string& door : doors) {
+    provisionDoor(door, options, manifest);
+  }
+  fclose(manifest);
+
+  printf("%zu doors provisioned, secrets in %s\n", doors.size(), manifestPath.c_str());
+  return 0;
+}